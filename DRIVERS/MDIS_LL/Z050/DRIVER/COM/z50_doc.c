@@ -46,7 +46,33 @@
 
     \n
     \section Variants Variants
-    (no variants)
+    The standard driver (z50, z50_sw, z50_io, z50_io_sw) selects the
+    register layout at runtime via descriptor key Z50_D302I.
+
+    For systems with only one kind of hardware, variants with the layout
+    fixed at compile time are available. They use constant register
+    offsets instead of loading them from the driver handle, so the code
+    is smaller; the register (bus) accesses are the same as with the
+    runtime-selected driver in the same configuration (see z50_bench):
+
+    <table border="0">
+    <tr><td><b>Driver</b></td><td><b>Makefile</b></td>
+        <td><b>Hardware</b></td></tr>
+    <tr><td>z50_bioc</td><td>driver_bioc.mak</td><td>BIOC</td></tr>
+    <tr><td>z50_bioc_sw</td><td>driver_bioc_sw.mak</td>
+        <td>BIOC, swapped access</td></tr>
+    <tr><td>z50_d302i</td><td>driver_d302i.mak</td><td>D302i</td></tr>
+    <tr><td>z50_d302i_sw</td><td>driver_d302i_sw.mak</td>
+        <td>D302i, swapped access</td></tr>
+    </table>
+
+    These variants refuse to initialize if descriptor key Z50_D302I
+    contradicts their hardware type. The D302i variants request an address
+    space covering the control register and always use the global
+    interrupt pending/enable bits (see Z50_D302I_GIP). Compared with the
+    default D302i configuration of the runtime-selected driver, this
+    saves one register read per foreign interrupt and costs one more per
+    own interrupt.
 
     \n \section FuncDesc Functional Description
 
@@ -85,6 +111,23 @@
     
     Data direction of the ports cannot be programmed.
 
+    M_getblock() reads the input registers of all channels with a single
+    call, independent of the current channel. The buffer receives one
+    32 bit value per channel (channel 0 first): four values on the D302i,
+    one on the BIOC. The registers are read with the interrupt masked, so
+    the returned input image is consistent. The buffer must hold at least
+    4 bytes; if it is smaller than needed for all channels, only the first
+    channels are returned.
+
+    M_setblock() is the counterpart for the outputs: the buffer contains
+    one 32 bit output value per channel (channel 0 first), and all output
+    registers are written within a single call with the output lock held.
+    This avoids intermediate output states that would be visible when
+    updating the channels one by one with M_write(). SetStat
+    Z50_SETBLOCK_MODE=Z50_SBM_WAVE changes M_setblock() to waveform
+    playback, SetStat Z50_GETBLOCK_MODE=Z50_GBM_SAMPLE changes
+    M_getblock() to reading input samples (see below).
+
 
     \n \subsection edgedetection Edge detection
 
@@ -99,6 +142,50 @@
 
     GetStat Z50_EDGE_FALL works the same way but for falling edges.
 
+    Block GetStat Z50_BLK_EDGE_ALL returns and clears the rising and
+    falling edges of all channels in a Z50_EDGE_ALL_PB with interrupts
+    masked only once, so the snapshot of all channels is consistent and
+    polling a D302i needs one call instead of switching channels with
+    M_MK_CH_CURRENT and two GetStats per channel.
+
+    Block GetStat Z50_BLK_STATUS returns the input register, the rising
+    and falling edges (cleared like Z50_EDGE_RAISE/FALL) and the
+    interrupt counter of the current channel in a Z50_STATUS_PB. All
+    four values are taken with interrupts masked, so they are coherent,
+    and a polling loop needs one call instead of M_read() and two
+    GetStats.
+
+
+    \n \subsection usermap User mapping of the registers
+
+    The MDIS low-level interface has no hook to map device memory into
+    an application, so the driver cannot hand out a mapping itself. For
+    polling loops that cannot afford a system call per sample, the
+    application may map the register window of the unit on its own (e.g.
+    with Linux UIO or /dev/mem at the address used by the device's BBIS)
+    and read the inputs with plain loads. z50_map.h provides the read
+    accessors for the BIOC and D302i layouts (Z50_MAP_BIOC_INPUT(),
+    Z50_MAP_D302I_INPUT() ...); Block GetStat Z50_BLK_LAYOUT returns the
+    layout of the device in a Z50_LAYOUT_PB for Z50_MAP_INPUT() and
+    Z50_MAP_OUTPUT().
+
+    This feature is description-only: Z50_BLK_LAYOUT returns register
+    offsets and the window size, but no mapping and no physical address.
+    An LL driver only receives the virtual address from MDIS, the
+    application must take the physical base from the board configuration
+    (e.g. the PCI BAR of the FPGA plus the unit offset).
+
+    Only the input and output registers may be read this way. Edge
+    registers are cleared on write by the driver and the output register
+    has a shadow copy, so edges, interrupts and output changes must still
+    go through the driver.
+
+    For the same reason the driver offers no input image shared with
+    user space. Several applications watching the same inputs can use
+    M_read() and Block GetStat Z50_BLK_EDGE_COUNT (with \a reset 0), which
+    do not clear edges for the others; each call is still a system call
+    and is serialized by the MDIS call lock.
+
 
     
     \n \subsection interrupts Interrupt handling and signals
@@ -117,6 +204,278 @@
     The current status can be read back using GetStats Z50_IRQ_EDGE_RISE 
     and Z50_IRQ_EDGE_FALL.
 
+    The interrupt routine only checks channels that have at least one
+    interrupt enabled and returns immediately if no channel has. This keeps
+    the cost of foreign interrupts on a shared interrupt line low.
+
+    On the D302i, descriptor key Z50_D302I_GIP=1 additionally lets the
+    interrupt routine check the global interrupt pending bit (GIP) of the
+    control register first, so a foreign interrupt costs only one register
+    read. M_setstat(M_MK_IRQ_ENABLE) then switches the global interrupt
+    enable bit (GIEN) instead of clearing all interrupt masks, i.e. the
+    masks are kept while interrupts are disabled. GIEN is cleared when
+    the device is opened and closed. The control register is
+    located at offset 0x104, so the mapped address space of the board must
+    cover it.
+
+    By default a signal is sent on every interrupt, so a chattering input
+    can flood the application with signals. SetStat Z50_NOTIFY_HOLDOFF
+    sets a minimum interval between two signals in milliseconds. Edges
+    occurring within the holdoff are still collected (see Z50_EDGE_RAISE/
+    Z50_EDGE_FALL) and reported by one signal sent by the driver timer
+    when the holdoff has expired. SetStat Z50_NOTIFY_THRESHOLD sends the
+    signal before the holdoff has expired once the given number of edges
+    is pending. Both default to 0 (signal on every interrupt). The
+    holdoff is measured with the timestamp clock (see below).
+
+    \n \subsection quarantine Interrupt storm protection
+
+    A faulty sensor on an input with interrupt enabled may generate
+    interrupts fast enough to starve the system. SetStat
+    Z50_QUAR_THRESHOLD sets the maximum number of edges per input within
+    a window of Z50_QUAR_WINDOW milliseconds (default 100). An input
+    reaching the threshold is quarantined: the interrupt routine masks it
+    in the interrupt enable registers. After Z50_QUAR_BACKOFF milliseconds
+    (default 1000) the driver timer discards the edges latched meanwhile
+    and re-arms the input with the interrupt mask set by the user.
+    Threshold 0 (default) switches the protection off and re-arms all
+    quarantined inputs.
+
+    GetStat Z50_QUAR_INPUTS returns the quarantined inputs of the current
+    channel. Block GetStat Z50_BLK_QUARANTINE returns the quarantined
+    inputs of all channels and how often each input was quarantined
+    (reset after reading if \a reset is 1). GetStats Z50_IRQ_EDGE_RAISE
+    and Z50_IRQ_EDGE_FALL still return the masks set by the user.
+
+
+    \n \subsection events Edge event ring
+
+    Besides accumulating the edge bits, the interrupt routine stores one
+    Z50_EVENT record per channel and interrupt into a ring buffer. Each
+    record contains a sequence number, a timestamp, the channel, the masks
+    of inputs with raising and falling edges and the state of the inputs
+    at interrupt time. Several edges on the same input are therefore not
+    merged into one bit, and their order and timing are preserved.
+
+    The ring is drained with block GetStat Z50_BLK_EVENTS. The data buffer
+    starts with a Z50_EVENT_HDR structure followed by room for any number
+    of Z50_EVENT records. The driver fills as many records as fit, oldest
+    first, and reports in the header:
+
+    - \a count: number of returned records
+    - \a pending: number of records still queued
+    - \a lost: number of events dropped because the ring was full, since
+      the last request
+    - \a lostTotal: number of dropped events since M_open()
+    - \a tickRate: timestamp ticks per second
+
+    Dropped events still consume a sequence number, so gaps in \a seq show
+    where events were lost. The ring size is set with descriptor key
+    Z50_EVENT_DEPTH; 0 (default) disables the ring (the GetStat then
+    returns ERR_LL_ILL_FUNC), so the interrupt routine does not read the
+    input register unless the ring is used.
+
+    \n \subsection edgecount Edge counters
+
+    The interrupt routine maintains 64 bit counters of raising and falling
+    edges for every input of every channel. Block GetStat Z50_BLK_EDGE_COUNT
+    returns all counters in a Z50_EDGE_COUNT_PB structure; \a numCh tells
+    how many channels are valid. If \a reset is 1, the counters are cleared
+    in the same interrupt-masked section, so no edge is lost or counted
+    twice between two requests.
+
+    Only edges on inputs with interrupts enabled are counted. Several edges
+    of one input that occur before the interrupt is serviced are latched
+    as one edge by the hardware and are counted once.
+
+    \n \subsection freq Frequency and period measurement
+
+    SetStat Z50_FREQ_INPUTS enables frequency and period measurement for
+    the inputs of the current channel whose bits are set. The interrupt
+    routine then timestamps every raising edge of these inputs and
+    computes, per input:
+
+    - the last period
+    - the shortest and longest period since the last reset
+    - the number of periods and the exact length of the last gate, and
+      the average frequency in Hz derived from them
+
+    The gate time is set with SetStat Z50_FREQ_GATE in milliseconds
+    (default 1000). Gates are aligned to edges, i.e. a gate ends with the
+    first edge after the gate time has elapsed, so the result is not
+    distorted by partial periods.
+
+    Block GetStat Z50_BLK_FREQ returns the results of all inputs in one
+    Z50_FREQ_PB structure. Periods and gate times are given in timestamp
+    ticks; \a tickRate holds the number of ticks per second. If \a reset
+    is 1, the min/max periods are reset after reading. If an input had no
+    edge for longer than the gate time and twice its last period, the
+    frequency is reported as 0.
+
+    Raising edge interrupts must be enabled for the measured inputs (see
+    Z50_IRQ_EDGE_RAISE). The resolution is that of the timestamps (see
+    below). With a timestamp clock slower than 100 kHz, e.g. the OSS
+    tick, SetStat Z50_FREQ_INPUTS (value != 0) and Z50_BLK_FREQ return
+    ERR_LL_ILL_FUNC.
+
+    \n \subsection waitedge Waiting for edges
+
+    As an alternative to signals, a thread can block in the driver until
+    an edge occurs, using block GetStat Z50_BLK_WAIT_EDGE with a
+    Z50_WAIT_PB structure. \a raiseMask and \a fallMask select the inputs
+    of the current channel to wait for; \a timeout is given in
+    milliseconds (-1 waits forever, 0 only checks). On return, \a raise
+    and \a fall contain the matching edges. The call returns ERR_OSS_TIMEOUT
+    if no matching edge occurred within the timeout.
+
+    The call returns at once if a matching edge was recorded by the
+    interrupt routine before. The returned edges are cleared, i.e. they
+    are no longer reported by GetStats Z50_EDGE_RAISE and Z50_EDGE_FALL.
+    Inputs with interrupts enabled (Z50_IRQ_EDGE_RAISE/FALL) wake up the
+    caller at once. Other inputs only wake it up if their channel is
+    sampled (Z50_SAMPLING), with a delay of up to one sample period. Other
+    calls to the device are not blocked while a
+    thread is waiting; however only one thread can wait at a time (a
+    second caller gets ERR_LL_DEV_BUSY).
+
+    \n \subsection wave Waveform playback
+
+    With SetStat Z50_SETBLOCK_MODE set to Z50_SBM_WAVE, M_setblock()
+    loads a sequence of Z50_WAVE_STEP records and plays it back on the
+    outputs of the current channel, timed by the driver. Each step sets
+    the outputs selected in \a mask to \a value and then waits \a delay
+    microseconds before the next step is output. M_setblock() returns at
+    once; playback starts with the next timer tick.
+
+    The driver timer is an OSS alarm with the period given by descriptor
+    key Z50_TIMER_PERIOD in milliseconds (default 1). The OSS may round
+    the period, e.g. to the system tick (4 ms at HZ=250); the driver uses
+    the period actually granted for all timed functions, GetStat
+    Z50_TIMER_TICK returns it in milliseconds. Delays are rounded up to
+    whole timer periods; steps with delay 0 are output in the same tick
+    as the following step; a waveform without any delay is rejected
+    (ERR_LL_ILL_PARAM). The alarm only runs while a timed function is
+    active.
+
+    SetStat Z50_WAVE_LOOPS sets the number of repetitions for the next
+    waveform (default 1, 0=endless, negative values are rejected with
+    ERR_LL_ILL_PARAM), a running playback is not affected. SetStat
+    Z50_WAVE_STOP aborts the playback, the outputs keep their current
+    state. GetStat Z50_WAVE_STATE returns Z50_WAVE_RUNNING while
+    the waveform is played back. A new waveform can only be loaded when
+    the previous one has finished (otherwise ERR_LL_DEV_BUSY).
+
+    The end of the playback can be awaited with block GetStat
+    Z50_BLK_WAVE_WAIT (timeout in milliseconds, -1 waits forever) or
+    signalled by installing a signal with SetStat Z50_WAVE_SIGNAL (value 0
+    removes the signal). M_write() and SetStats Z50_SET_PORTS/Z50_CLR_PORTS
+    may be used during playback, e.g. for outputs not touched by the
+    waveform masks.
+
+    \n \subsection pwm Software PWM
+
+    Block SetStat Z50_BLK_PWM drives the outputs of the current channel
+    selected in \a mask of a Z50_PWM_PB structure with a pulse width
+    modulated signal: the output is high for \a duty microseconds of
+    every \a period. Period and high time are rounded up to periods of
+    the driver timer (see Z50_TIMER_PERIOD). A period of 0 switches PWM
+    off for the selected outputs; they keep their last state.
+
+    On every timer tick the driver computes the new state of all PWM
+    outputs of a channel and updates the output register with a single
+    write (only if the state changed), independent of the number of PWM
+    outputs. Outputs configured with the same call run in phase.
+
+    GetStat Z50_PWM_OUTPUTS returns the PWM outputs of the current
+    channel. Block GetStat Z50_BLK_PWM returns period and high time of
+    the output selected by the lowest bit set in \a mask (0 if PWM is
+    off). Other writes to PWM outputs are overwritten with the next tick.
+
+    \n \subsection sampling Input sampling
+
+    Instead of polling the inputs with M_read(), the driver timer can
+    sample the inputs of the current channel at a fixed rate into a
+    ring buffer. SetStat Z50_SAMPLE_PERIOD sets the sample period in
+    milliseconds (rounded up to periods of the driver timer), SetStat
+    Z50_SAMPLING=1 starts sampling of the current channel and discards
+    all queued samples, Z50_SAMPLING=0 stops it.
+
+    Each Z50_SAMPLE record contains a sequence number, the state of the
+    inputs and the raising and falling edges since the previous sample,
+    so pulses shorter than the sample period are visible as well. Edges
+    of inputs without interrupt are cleared by the sampling, but still
+    reported by GetStats Z50_EDGE_RAISE/Z50_EDGE_FALL.
+
+    With SetStat Z50_GETBLOCK_MODE=Z50_GBM_SAMPLE, M_getblock() drains
+    the ring: the buffer receives a Z50_SAMPLE_HDR followed by as many
+    records as fit. The size of the ring is set with descriptor key
+    Z50_SAMPLE_DEPTH; if it is full, new samples are dropped and counted
+    in \a lost (their sequence numbers are skipped). The time of a
+    sample relative to the start is \a seq * \a period.
+
+    SetStat Z50_SAMPLE_FORMAT selects the record format (only while
+    sampling is stopped):
+
+    - Z50_SMP_RAW (default): one record per sample
+    - Z50_SMP_RLE: a record is only stored for the first sample and for
+      samples where the inputs changed or edges occurred. A record
+      stands for all samples up to the next record, i.e. its run length
+      is the \a seq of the next record minus its own \a seq. For the
+      newest record the run is still open and ends at \a nextSeq of the
+      header.
+
+    For slowly changing inputs Z50_SMP_RLE reduces ring usage and
+    copying by orders of magnitude; the header field \a format tells
+    which encoding the records use.
+
+    \n \subsection timestamps Timestamps
+
+    On Linux the timestamps are microseconds from ktime_get(); on other
+    operating systems they come from OSS_TickGet() by default. Another
+    clock, e.g. a CPU cycle counter, can be selected at build time by
+    defining the macros Z50_TIMESTAMP() and Z50_TIMESTAMP_RATE(). The
+    timestamps are 32 bit values; the driver only uses differences, which
+    stay valid when the counter wraps.
+
+    Functions that need a fine clock (frequency measurement, interrupt
+    timing histograms) return ERR_LL_ILL_FUNC if the timestamp rate is
+    below 100 kHz, instead of returning results quantized to the OSS
+    tick.
+
+    \n \subsection histograms Interrupt timing histograms
+
+    SetStat Z50_HISTOGRAM=1 lets the interrupt routine record three
+    histograms (interrupts of other devices are not recorded):
+
+    - \a isrTime: duration of Z50_Irq()
+    - \a ntfDelay: time from the interrupt to the signal sent to the
+      application, including the holdoff of notification coalescing
+    - \a irqGap: time between two interrupts
+
+    Each histogram has Z50_HIST_BUCKETS log2 buckets: bucket 0 counts
+    values 0..1, bucket n values 2^n..2^(n+1)-1. It also holds the number
+    of values and the largest value. Block GetStat Z50_BLK_HIST returns
+    all histograms at once (and resets them if \a reset is 1); values are
+    given in timestamp ticks, \a tickRate holds the ticks per second.
+
+    The histograms require a fine timestamp clock (see \ref timestamps):
+    with the OSS tick, SetStat Z50_HISTOGRAM=1 and GetStat Z50_BLK_HIST
+    fail with ERR_LL_ILL_FUNC. On such systems define Z50_TIMESTAMP(),
+    e.g. for a CPU cycle counter, when building the driver.
+
+    \n \subsection stats Driver statistics
+
+    The driver counts the calls of all entry points (M_read(), M_write(),
+    M_setstat(), M_getstat(), M_getblock(), M_setblock()), the calls of
+    M_setstat() per Z50 specific code, the interrupts of this device and
+    of other devices sharing the interrupt line, and the signals sent or
+    failed to send. The entry point counters are serialized by the MDIS
+    call lock; the interrupt and signal counters are only changed by the
+    interrupt routine or with the device interrupt masked.
+    Block GetStat Z50_BLK_STATS returns all counters in a Z50_STATS
+    structure (and resets them if \a reset is 1). This shows which
+    application calls the device how often.
+
 
     \n \subsection debounce Debouncing
     
@@ -137,10 +496,29 @@
     The current status can be read back using GetStat Z50_BLK_DEBOUNCE. 
     Like its counterpart it takes a pointer to a Z50_DEBOUNCE_PB structure. 
     \a Input has to be given by user, \a time is filled by the driver.
+    Both calls return ERR_LL_USERBUF if the block is smaller than
+    Z50_DEBOUNCE_PB.
 
     When the debouncing time is updated, the new value is used after the
     current cycle is finished, i.e. the input has to be low for more than the
     old debouncing time.
+
+
+    \n \subsection shadow Shadow registers
+
+    The interrupt mask, output and debouncing registers are only written
+    by the driver. The driver keeps shadow copies of them and uses these
+    instead of reading the hardware: the interrupt routine and the edge
+    GetStats take the interrupt masks from the shadows, and SetStats
+    Z50_SET_PORTS/Z50_CLR_PORTS update the output register with a single
+    write instead of a read-modify-write cycle. GetStat Z50_BLK_DEBOUNCE
+    returns the shadow values. GetStats Z50_IRQ_EDGE_RAISE and
+    Z50_IRQ_EDGE_FALL return the masks set by the user, which differ from
+    the hardware only for quarantined inputs.
+
+    GetStat Z50_SHADOW_CHECK compares all shadows with the hardware
+    registers and returns 0 if they match. Otherwise the Z50_SHADOW_xxx
+    flags of the differing register groups are set.
     
     \n \subsection default Default values
     M_open() and M_close() set all ports to default values: 
@@ -196,12 +574,152 @@
         <td>0..1, default: 0</td>
     </tr>
 
+    <tr><td>Z50_D302I_GIP</td>
+        <td>D302i: use global interrupt pending/enable bits if 1</td>
+        <td>0..1, default: 0</td>
+    </tr>
+
+    <tr><td>Z50_EVENT_DEPTH</td>
+        <td>Number of records in edge event ring (0=disabled)</td>
+        <td>0..n, default: 0</td>
+    </tr>
+
+    <tr><td>Z50_TIMER_PERIOD</td>
+        <td>Period of driver timer [ms] (waveform playback, PWM,
+            sampling)</td>
+        <td>1..n, default: 1</td>
+    </tr>
+
+    <tr><td>Z50_SAMPLE_DEPTH</td>
+        <td>Number of records in input sample ring (0=disabled)</td>
+        <td>0..n, default: 1024</td>
+    </tr>
+
     </table>
 
     
     \n \section codes Z50 specific Getstat/Setstat codes
     see \ref getstat_setstat_codes "section about Getstat/Setstat codes"
 
+    \n \section benchmark Benchmark
+
+    z50_bench measures the driver entry points most used by applications:
+    M_read(), M_write(), SetStats Z50_SET_PORTS/Z50_CLR_PORTS, GetStat
+    Z50_EDGE_RAISE, M_getblock() and M_setblock(). Each test calls the
+    function -n times without timing for the throughput, then once more
+    with a timestamp around each call for the latency percentiles. One
+    CSV line per test is printed:
+
+    \code
+    test,ops,ops_per_s,min_ns,p50_ns,p90_ns,p99_ns,max_ns
+    \endcode
+
+    The write tests toggle the outputs given with -m (default none) on
+    the current channel; blkwrite writes the output register of channel
+    0 only. Latencies require a fine clock, which is clock_gettime() on
+    Linux.
+
+    Linked against the simulator (see below) z50_bench additionally
+    prints the register reads and writes per call and runs the tests
+    isr and isrnot for the interrupt routine. z50_bench_bioc and
+    z50_bench_d302i use the Z50_BIOC_ONLY/Z50_D302I_ONLY driver variants;
+    "make variants" prints the register accesses per call of all
+    variants:
+
+    \code
+    test      bioc  bioc_only  d302i  d302i_gip  d302i_only   (reads)
+    read      1     1          1      1          1
+    edge      1     1          1      1          1
+    blkread   1     1          4      4          4
+    isr       2     2          2      3          3
+    isrnot    2     2          2      1          1
+    \endcode
+
+    Writes are equal in all variants. The fixed variants only save the
+    offset loads from the handle; their cycle gain can only be measured
+    on the target, the host timings are within noise.
+
+    \n \section latency Round-trip latency test
+
+    z50_latency is the acceptance test for the real-time response. It
+    toggles one output with Z50_SET_PORTS/Z50_CLR_PORTS and waits with
+    Z50_BLK_WAIT_EDGE for the edge on the input of the same number,
+    which must be wired to the output. The time from switching the
+    output to the return of the wait covers the output write, the input
+    and debounce logic, the interrupt routine and the wake-up of the
+    waiting thread. After -n round trips the program prints one CSV line
+    with the number of round trips and timeouts, minimum, mean, standard
+    deviation (jitter), 50/99/99.9 percentiles and maximum in ns; -h adds
+    the histogram (bucket width -w).
+
+    Linked against the simulator, the outputs are mirrored into the input
+    registers, so no wiring is needed.
+
+    \n \section dbcalib Debounce auto-calibration
+
+    z50_dbcalib measures the bounce time of the contacts and programs the
+    smallest debounce value that suppresses it. It switches debouncing
+    off for the inputs given with -m, enables interrupts on both edges and
+    reads the edge events with their timestamps (Z50_BLK_EVENTS, the
+    event ring must be enabled with Z50_EVENT_DEPTH) for -t seconds while
+    the contacts are operated. Edges of one input with less than -g ms in between form a
+    burst; the time from the first to the last edge is the bounce time.
+
+    For each input one CSV line with the number of bursts, edges per
+    burst and the minimum, median, 99 percentile and maximum bounce time
+    in us is printed. The longest burst (plus one timestamp tick) times
+    the margin -p gives the debounce value in 50us units. It is
+    programmed per input on BIOC and per channel (maximum of the inputs)
+    on D302i; inputs without edges keep their old value, -n only prints
+    the result.
+
+    With the default OSS tick as timestamp the result is coarse; build
+    the driver with a fine Z50_TIMESTAMP for calibration. Edges between
+    two interrupts are merged into one event and lost events shorten the
+    measured bursts, so the margin should cover the interrupt latency.
+
+    \n \section simulator Register-level simulator
+
+    TOOLS/Z50_SIM builds the driver on a host without hardware and
+    without the MDIS kernel (make MDIS_INC_DIR=<MDIS include dir>). With
+    the switch Z50_SIM the driver includes z50_sim.h instead of
+    maccess.h, so every register access goes to z50_sim.c. The simulator
+    provides:
+
+    - the BIOC and D302i register windows with raw and debounced inputs,
+      write-1-to-clear edge latches, interrupt masks, debounce registers
+      and GIEN/GIP; the window has the size requested by the driver
+      (LL_INFO_ADDRSPACE), plus the control register with Z50_D302I_GIP,
+      and accesses outside of it abort the program
+    - a virtual clock, advanced by Z50SIM_Run() and by blocking waits of
+      the driver; timestamps are given in microseconds unless a coarse
+      clock is selected with Z50SIM_TsRate(), Z50SIM_AlarmRes() rounds
+      alarm periods like an OS tick
+    - scheduled input changes, bouncing contacts, square waves and a
+      loopback from outputs to inputs
+    - OSS alarms, semaphores, signals and spin locks on the virtual clock
+    - an interrupt line calling Z50_Irq() while an enabled edge is
+      latched, and Z50SIM_IrqInject() for interrupts of other devices
+    - M_open() ... M_setblock(), so applications link against
+      libz50sim.a instead of the MDIS API library
+    - counters of register accesses, interrupts and alarms
+
+    z50_simrun executes command scripts against the simulated device,
+    e.g. to check the driver's reaction on a bouncing input:
+
+    \code
+    setstat Z50_IRQ_EDGE_RAISE 1    # interrupt on raising edge of input 0
+    setstat M_MK_IRQ_ENABLE 1
+    bounce 1 1 3 200                # 3 bounces, 200us apart
+    run 10000
+    events
+    counters
+    \endcode
+
+    make test runs the regression scripts in TOOLS/Z50_SIM/COM/tests
+    (one or more per driver function) and compares their output with
+    the expected one.
+
     \n \section Documents Overview of all Documents
 
     \subsection z50_simp  Simple example for using the driver
@@ -9,7 +9,8 @@
  *
  *     Required: OSS, DESC, DBG libraries
  *
- *     \switches _ONE_NAMESPACE_PER_DRIVER_
+ *     \switches _ONE_NAMESPACE_PER_DRIVER_, Z50_TIMESTAMP,
+ *               Z50_BIOC_ONLY, Z50_D302I_ONLY, Z50_SIM
  *
  *
  *---------------------------------------------------------------------------
@@ -34,7 +35,11 @@
 #define _NO_LL_HANDLE       /* ll_defs.h: don't define LL_HANDLE struct */
 
 #include <MEN/men_typs.h>   /* system dependent definitions   */
-#include <MEN/maccess.h>    /* hw access macros and types     */
+#ifdef Z50_SIM
+# include "z50_sim.h"       /* simulated register window      */
+#else
+# include <MEN/maccess.h>   /* hw access macros and types     */
+#endif
 #include <MEN/dbg.h>        /* debug functions                */
 #include <MEN/oss.h>        /* oss functions                  */
 #include <MEN/desc.h>       /* descriptor functions           */
@@ -52,10 +57,53 @@ static const char IdentString[]=MENT_XSTR(MAK_REVISION);
 +-----------------------------------------*/
 /* general defines */
 #define CH_NUMBER           4           /**< number of device channels */
+#define IN_NUMBER           32          /**< number of inputs per channel */
+#define DEBOUNCE_NUMBER     32          /**< max. number of debounce regs */
+#ifdef Z50_D302I_ONLY
+# define IS_D302I_DEFAULT   1           /**< default for Z50_D302I */
+#else
+# define IS_D302I_DEFAULT   0           /**< default for Z50_D302I */
+#endif
 #define USE_IRQ             TRUE        /**< interrupt required  */
 #define ADDRSPACE_COUNT     1           /**< nbr of required address spaces */
-#define ADDRSPACE_SIZE      256         /**< size of address space */
+#ifdef Z50_D302I_ONLY
+# define ADDRSPACE_SIZE     0x108       /**< size of address space */
+#else
+# define ADDRSPACE_SIZE     256         /**< size of address space */
+#endif
 #define OSH                 llHdl->osHdl
+#define EVT_DEPTH_DEFAULT   0           /**< default size of event ring */
+#define FREQ_GATE_DEFAULT   1000        /**< default gate time [ms] */
+#define TIMER_PERIOD_DEFAULT 1          /**< default alarm period [ms] */
+#define SMP_DEPTH_DEFAULT   1024        /**< default size of sample ring */
+#define QUAR_WINDOW_DEFAULT 100         /**< default quarantine window [ms] */
+#define QUAR_BACKOFF_DEFAULT 1000       /**< default quarantine time [ms] */
+#define HIST_BUCKETS        32          /**< buckets per histogram */
+#define STAT_CODES          32          /**< counted codes M_DEV_OF+n */
+#define STAT_BLK_CODES      16          /**< counted codes M_DEV_BLK_OF+n */
+
+/* users of the driver timer (LL_HANDLE.timerUsers) */
+#define TMR_WAVE            0x01        /**< waveform playback */
+#define TMR_PWM             0x02        /**< software PWM */
+#define TMR_SAMPLE          0x04        /**< input sampling */
+#define TMR_NOTIFY          0x08        /**< deferred signals */
+#define TMR_QUAR            0x10        /**< input quarantine */
+
+/* timestamp source, may be replaced by a finer clock at build time */
+#ifndef Z50_TIMESTAMP
+# if defined(LINUX) && defined(__KERNEL__)
+#  include <linux/ktime.h>
+#  define Z50_TIMESTAMP()       ((u_int32)ktime_to_us( ktime_get() ))
+#  define Z50_TIMESTAMP_RATE()  1000000                 /**< ticks/sec */
+# else
+#  define Z50_TIMESTAMP()       OSS_TickGet( OSH )      /**< timestamp */
+#  define Z50_TIMESTAMP_RATE()  OSS_TickRateGet( OSH )  /**< ticks/sec */
+# endif
+#endif
+
+/* timestamps fine enough for frequency measurement and histograms */
+#define TS_FINE_RATE        100000      /**< min. rate [ticks/sec] */
+#define TS_FINE()           (Z50_TIMESTAMP_RATE() >= TS_FINE_RATE)
 
 /* debug defines */
 #define DBG_MYLEVEL         llHdl->dbgLevel   /**< debug level */
@@ -71,16 +119,98 @@ static const char IdentString[]=MENT_XSTR(MAK_REVISION);
 #define BIOC_CONTROL        0x20        /**< control register */
 #define BIOC_DEBOUNCE       0x80        /**< debouncing register */
 
+/*
+ * Register layout. The variants built with Z50_BIOC_ONLY or Z50_D302I_ONLY
+ * support one kind of hardware only, so all offsets are constants and
+ * loops over the channels can be unrolled by the compiler.
+ */
+#if defined(Z50_D302I_ONLY)
+# define IS_D302I(h)            1
+# define USE_GIP(h)             1
+# define REG_INPUT(h)           D302I_INPUT(0)
+# define REG_OUTPUT(h)          D302I_OUTPUT(0)
+# define REG_EDGE_RAISE(h)      D302I_EDGE_RAISE(0)
+# define REG_EDGE_FALL(h)       D302I_EDGE_FALL(0)
+# define REG_IRQ_EDGE_RAISE(h)  D302I_IRQ_EDGE_RAISE(0)
+# define REG_IRQ_EDGE_FALL(h)   D302I_IRQ_EDGE_FALL(0)
+# define REG_DEBOUNCE(h)        D302I_DEBOUNCE(0)
+# define REG_CONTROL(h)         0
+#elif defined(Z50_BIOC_ONLY)
+# define IS_D302I(h)            0
+# define USE_GIP(h)             0
+# define REG_INPUT(h)           BIOC_INPUT
+# define REG_OUTPUT(h)          BIOC_OUTPUT
+# define REG_EDGE_RAISE(h)      BIOC_EDGE_RAISE
+# define REG_EDGE_FALL(h)       BIOC_EDGE_FALL
+# define REG_IRQ_EDGE_RAISE(h)  BIOC_IRQ_EDGE_RAISE
+# define REG_IRQ_EDGE_FALL(h)   BIOC_IRQ_EDGE_FALL
+# define REG_DEBOUNCE(h)        BIOC_DEBOUNCE
+# define REG_CONTROL(h)         BIOC_CONTROL
+#else
+# define IS_D302I(h)            ((h)->d302i)
+# define USE_GIP(h)             ((h)->useGip)
+# define REG_INPUT(h)           ((h)->inputReg)
+# define REG_OUTPUT(h)          ((h)->outputReg)
+# define REG_EDGE_RAISE(h)      ((h)->edgeRaiseReg)
+# define REG_EDGE_FALL(h)       ((h)->edgeFallReg)
+# define REG_IRQ_EDGE_RAISE(h)  ((h)->irqEdgeRaiseReg)
+# define REG_IRQ_EDGE_FALL(h)   ((h)->irqEdgeFallReg)
+# define REG_DEBOUNCE(h)        ((h)->debounceReg)
+# define REG_CONTROL(h)         ((h)->controlReg)
+#endif
+
+/* number of input/output and debounce registers */
+#define NUM_REGS(h)             (IS_D302I(h) ? CH_NUMBER : 1)
+#define NUM_DEBOUNCE(h)         (IS_D302I(h) ? CH_NUMBER : DEBOUNCE_NUMBER)
+
 
 /*-----------------------------------------+
 |  TYPEDEFS                                |
 +-----------------------------------------*/
+/** frequency measurement state of one input */
+typedef struct {
+    u_int32         valid;          /**< lastTime is valid */
+    u_int32         lastTime;       /**< time of last raising edge */
+    u_int32         period;         /**< last period */
+    u_int32         minPeriod;      /**< shortest period */
+    u_int32         maxPeriod;      /**< longest period */
+    u_int32         gateStart;      /**< start of current gate */
+    u_int32         gatePeriods;    /**< periods in current gate */
+    u_int32         resPeriods;     /**< periods in last gate */
+    u_int32         resTime;        /**< length of last gate */
+} FREQ_IN;
+
+/** log2 histogram (same layout as Z50_HIST) */
+typedef struct {
+    u_int32         count;          /**< number of values */
+    u_int32         max;            /**< largest value */
+    u_int32         bucket[HIST_BUCKETS]; /**< values per log2 bucket */
+} HIST;
+
+/** driver statistics (same layout as Z50_STATS) */
+typedef struct {
+    u_int32         read;           /**< Z50_Read calls */
+    u_int32         write;          /**< Z50_Write calls */
+    u_int32         setStat;        /**< Z50_SetStat calls */
+    u_int32         getStat;        /**< Z50_GetStat calls */
+    u_int32         blockRead;      /**< Z50_BlockRead calls */
+    u_int32         blockWrite;     /**< Z50_BlockWrite calls */
+    u_int32         irqOwn;         /**< LL_IRQ_DEVICE */
+    u_int32         irqNotOwn;      /**< LL_IRQ_DEV_NOT */
+    u_int32         sigSent;        /**< signals sent */
+    u_int32         sigFailed;      /**< OSS_SigSend errors */
+    u_int32         setStatCode[STAT_CODES];        /**< per M_DEV_OF code */
+    u_int32         setStatBlkCode[STAT_BLK_CODES]; /**< per M_DEV_BLK_OF */
+    u_int32         setStatOther;   /**< other codes */
+} STATS;
+
 /** low-level handle */
 typedef struct {
     /* general */
     int32           memAlloc;       /**< size allocated for the handle */
     OSS_HANDLE      *osHdl;         /**< oss handle */
     OSS_IRQ_HANDLE  *irqHdl;        /**< irq handle */
+    OSS_SEM_HANDLE  *devSemHdl;     /**< device semaphore handle */
     DESC_HANDLE     *descHdl;       /**< desc handle */
     MACCESS         ma;             /**< hw access handle */
     MDIS_IDENT_FUNCT_TBL idFuncTbl; /**< id function table */
@@ -103,6 +233,119 @@ typedef struct {
     u_int32         irqEdgeFallReg; /**< offset of falling edge irq mask */
     u_int32         debounceReg;    /**< offset of debounce register */
     u_int32         controlReg;     /**< offset of control register */
+
+    /* shadow registers (only written by the driver) */
+    u_int32         shIrqRaise[CH_NUMBER]; /**< irq mask raising edge */
+    u_int32         shIrqFall[CH_NUMBER];  /**< irq mask falling edge */
+    u_int32         shOutput[CH_NUMBER];   /**< output registers */
+    u_int32         shDebounce[DEBOUNCE_NUMBER]; /**< debounce registers */
+    u_int32         irqChMask;      /**< channels with any irq enabled */
+    u_int32         useGip;         /**< use D302I_CTRL (GIP/GIEN) */
+
+    /* edge event ring */
+    void            *evtBuf;        /**< event ring (Z50_EVENT records) */
+    u_int32         evtMemSize;     /**< size allocated for evtBuf */
+    u_int32         evtDepth;       /**< number of records in evtBuf */
+    u_int32         evtIn;          /**< index of next record to write */
+    u_int32         evtCount;       /**< number of queued records */
+    u_int32         evtSeq;         /**< next event sequence number */
+    u_int32         evtLost;        /**< lost events since last request */
+    u_int32         evtLostTotal;   /**< lost events since init */
+
+    /* wait for edge */
+    OSS_SEM_HANDLE  *waitSem;       /**< semaphore signalled by irq */
+    int32           waitActive;     /**< a caller is waiting */
+    u_int32         waitCh;         /**< channel to wait for */
+    u_int32         waitRaiseMask;  /**< raising edges to wait for */
+    u_int32         waitFallMask;   /**< falling edges to wait for */
+
+    /* edge counters */
+    u_int64         edgeCntRaise[CH_NUMBER][IN_NUMBER]; /**< raising */
+    u_int64         edgeCntFall[CH_NUMBER][IN_NUMBER];  /**< falling */
+
+    /* frequency measurement */
+    u_int32         freqMask[CH_NUMBER]; /**< inputs to measure */
+    u_int32         freqGate;       /**< gate time [ms] */
+    u_int32         freqGateTicks;  /**< gate time [ticks] */
+    FREQ_IN         freq[CH_NUMBER][IN_NUMBER]; /**< state per input */
+
+    /* driver timer */
+    OSS_ALARM_HANDLE *alarmHdl;     /**< alarm for timed functions */
+    OSS_SPINL_HANDLE *outLock;      /**< protects outputs and timer data */
+    u_int32         timerPeriod;    /**< alarm period granted by OSS [ms] */
+    u_int32         timerUsers;     /**< functions using the alarm (TMR_xxx) */
+    u_int32         timerRunning;   /**< alarm is active */
+
+    /* waveform playback */
+    u_int32         sbMode;         /**< function of M_setblock (Z50_SBM_xxx) */
+    void            *waveBuf;       /**< steps (Z50_WAVE_STEP, delay in ticks) */
+    u_int32         waveMemSize;    /**< size allocated for waveBuf */
+    u_int32         waveSteps;      /**< number of steps */
+    u_int32         waveCh;         /**< output channel */
+    u_int32         waveIdx;        /**< index of next step */
+    u_int32         waveWait;       /**< ticks until next step */
+    u_int32         waveLoops;      /**< repetitions (0=endless) */
+    u_int32         waveLoopsLeft;  /**< repetitions left (0=endless) */
+    u_int32         waveState;      /**< Z50_WAVE_IDLE/RUNNING */
+    OSS_SEM_HANDLE  *waveSem;       /**< signalled at end of waveform */
+    OSS_SIG_HANDLE  *waveSig;       /**< signal sent at end of waveform */
+
+    /* software PWM */
+    u_int32         pwmMask[CH_NUMBER];            /**< PWM outputs */
+    u_int32         pwmPeriod[CH_NUMBER][IN_NUMBER]; /**< period [ticks] */
+    u_int32         pwmDuty[CH_NUMBER][IN_NUMBER];   /**< high time [ticks] */
+    u_int32         pwmCnt[CH_NUMBER][IN_NUMBER];    /**< tick in period */
+
+    /* input sampling */
+    u_int32         gbMode;         /**< function of M_getblock (Z50_GBM_xxx) */
+    void            *smpBuf;        /**< sample ring (Z50_SAMPLE) */
+    u_int32         smpMemSize;     /**< size allocated for smpBuf */
+    u_int32         smpDepth;       /**< number of records in ring */
+    u_int32         smpIn;          /**< index of next record to write */
+    u_int32         smpCount;       /**< number of queued records */
+    u_int32         smpSeq;         /**< sequence number of next sample */
+    u_int32         smpLost;        /**< samples lost since last read */
+    u_int32         smpOn;          /**< sampling active */
+    u_int32         smpCh;          /**< sampled channel */
+    u_int32         smpPeriod;      /**< sample period [timer ticks] */
+    u_int32         smpWait;        /**< ticks until next sample */
+    u_int32         smpRaise;       /**< raising edges seen by irq */
+    u_int32         smpFall;        /**< falling edges seen by irq */
+    u_int32         smpFormat;      /**< record format (Z50_SMP_xxx) */
+    u_int32         smpLast;        /**< input state of previous sample */
+
+    /* notification coalescing */
+    u_int32         ntfHoldoff;     /**< min. interval between signals [ms] */
+    u_int32         ntfHoldoffTicks; /**< same in timestamp ticks */
+    u_int32         ntfThreshold;   /**< pending edges forcing signal */
+    u_int32         ntfPending;     /**< edges since last signal */
+    u_int32         ntfLast;        /**< timestamp of last signal */
+
+    /* interrupt storm protection */
+    u_int32         reqIrqRaise[CH_NUMBER]; /**< irq mask set by user */
+    u_int32         reqIrqFall[CH_NUMBER];  /**< irq mask set by user */
+    u_int32         quarThreshold;  /**< edges per window (0=off) */
+    u_int32         quarWindow;     /**< rate window [ms] */
+    u_int32         quarBackoff;    /**< quarantine time [ms] */
+    u_int32         quarWinTicks;   /**< rate window [timer ticks] */
+    u_int32         quarWinLeft;    /**< ticks until window ends */
+    u_int32         quarBackTicks;  /**< quarantine time [timer ticks] */
+    u_int32         quarMask[CH_NUMBER];            /**< quarantined inputs */
+    u_int32         quarCnt[CH_NUMBER][IN_NUMBER];  /**< edges in window */
+    u_int32         quarLeft[CH_NUMBER][IN_NUMBER]; /**< ticks until re-arm */
+    u_int32         quarTotal[CH_NUMBER][IN_NUMBER]; /**< times quarantined */
+
+    /* interrupt timing histograms */
+    u_int32         histOn;         /**< histograms enabled */
+    HIST            histIsr;        /**< duration of Z50_Irq */
+    HIST            histNtf;        /**< interrupt to signal */
+    HIST            histGap;        /**< time between interrupts */
+    u_int32         histLastIrq;    /**< timestamp of last interrupt */
+    u_int32         histIrqSeen;    /**< histLastIrq is valid */
+    u_int32         ntfFirst;       /**< timestamp of first pending edge */
+
+    /* statistics */
+    STATS           stats;          /**< call and interrupt counters */
 } LL_HANDLE;
 
 /* include files which need LL_HANDLE */
@@ -130,6 +373,46 @@ static int32 Z50_Info(int32 infoType, ... );
 static char* Ident( void );
 static int32 Cleanup(LL_HANDLE *llHdl, int32 retCode);
 static void  gpioReset( LL_HANDLE *llHdl );
+static void  evtPut( LL_HANDLE *llHdl, u_int32 ch, u_int32 input,
+                     u_int32 raise,
+                     u_int32 fall, u_int32 time );
+static int32 waitEdge( LL_HANDLE *llHdl, int32 ch, Z50_WAIT_PB *pb );
+static void  edgeGet( LL_HANDLE *llHdl, int32 ch, u_int32 *raiseP,
+                      u_int32 *fallP );
+static u_int32 shadowCheck( LL_HANDLE *llHdl );
+static void  irqChMaskUpdate( LL_HANDLE *llHdl, int32 ch );
+static void  edgeCount( u_int64 *cnt, u_int32 mask );
+static void  freqEdge( LL_HANDLE *llHdl, u_int32 ch, u_int32 mask,
+                       u_int32 now );
+static u_int32 msToTicks( LL_HANDLE *llHdl, u_int32 msec );
+static u_int32 mulDiv( u_int32 a, u_int32 b, u_int32 c );
+static void  outputSet( LL_HANDLE *llHdl, int32 ch, u_int32 mask,
+                        u_int32 value );
+static void  alarmHandler( void *arg );
+static int32 timerStart( LL_HANDLE *llHdl, u_int32 user );
+static void  timerStop( LL_HANDLE *llHdl, u_int32 user );
+static int32 waveStart( LL_HANDLE *llHdl, int32 ch, void *buf, int32 size,
+                        int32 *nbrWrBytesP );
+static void  waveTick( LL_HANDLE *llHdl );
+static int32 waveWaitEnd( LL_HANDLE *llHdl, Z50_WAVE_WAIT_PB *pb );
+static int32 pwmSet( LL_HANDLE *llHdl, int32 ch, Z50_PWM_PB *pb );
+static void  pwmTick( LL_HANDLE *llHdl );
+static u_int32 usToTicks( LL_HANDLE *llHdl, u_int32 usec );
+static int32 sampleStart( LL_HANDLE *llHdl, int32 ch );
+static void  sampleStop( LL_HANDLE *llHdl );
+static void  sampleTick( LL_HANDLE *llHdl );
+static int32 sampleRead( LL_HANDLE *llHdl, void *buf, int32 size,
+                         int32 *nbrRdBytesP );
+static void  notify( LL_HANDLE *llHdl, u_int32 now, u_int32 edges );
+static void  notifyTick( LL_HANDLE *llHdl );
+static u_int32 bitCount( u_int32 mask );
+static int32 quarSet( LL_HANDLE *llHdl, u_int32 threshold );
+static void  quarCheck( LL_HANDLE *llHdl, u_int32 ch, u_int32 mask );
+static void  quarTick( LL_HANDLE *llHdl );
+static void  quarRearm( LL_HANDLE *llHdl, u_int32 ch, u_int32 mask );
+static u_int32 msToTmrTicks( LL_HANDLE *llHdl, u_int32 msec );
+static void  histAdd( HIST *h, u_int32 value );
+static void  sigSend( LL_HANDLE *llHdl, OSS_SIG_HANDLE *sig );
 
 
 /****************************** Z50_GetEntry ********************************/
@@ -169,6 +452,10 @@ static void  gpioReset( LL_HANDLE *llHdl );
  * DEBUG_LEVEL_DESC      OSS_DBG_DEFAULT  see dbg.h
  * DEBUG_LEVEL           OSS_DBG_DEFAULT  see dbg.h
  * ID_CHECK              1                0..1
+ * Z50_D302I_GIP         0                0..1
+ * Z50_EVENT_DEPTH       0                0..n (0=no event ring)
+ * Z50_TIMER_PERIOD      1                1..n [ms]
+ * Z50_SAMPLE_DEPTH      1024             0..n (0=no sampling)
  * \endcode
  *
  *  \param descP      \IN  pointer to descriptor data
@@ -211,6 +498,7 @@ static int32 Z50_Init(
     llHdl->memAlloc   = gotsize;
     llHdl->osHdl      = osHdl;
     llHdl->irqHdl     = irqHdl;
+    llHdl->devSemHdl  = devSemHdl;
     llHdl->ma         = *ma;
 
     /*------------------------------+
@@ -252,11 +540,116 @@ static int32 Z50_Init(
         return( Cleanup(llHdl,error) );
 
     /* Z50_D302I */
-    if ((error = DESC_GetUInt32(llHdl->descHdl, 0,
+    if ((error = DESC_GetUInt32(llHdl->descHdl, IS_D302I_DEFAULT,
                                 &llHdl->d302i, "Z50_D302I")) &&
         error != ERR_DESC_KEY_NOTFOUND)
         return( Cleanup(llHdl,error) );
 
+#if defined(Z50_BIOC_ONLY) || defined(Z50_D302I_ONLY)
+    /* hardware type fixed at compile time */
+    if( !llHdl->d302i != !IS_D302I(llHdl) ) {
+        DBGWRT_ERR((DBH, "*** LL - Z50_Init: Z50_D302I=%d not supported "
+                    "by this driver variant\n", llHdl->d302i));
+        return( Cleanup(llHdl,ERR_LL_DESC_PARAM) );
+    }
+#endif
+
+    /* Z50_D302I_GIP */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, 0,
+                                &llHdl->useGip, "Z50_D302I_GIP")) &&
+        error != ERR_DESC_KEY_NOTFOUND)
+        return( Cleanup(llHdl,error) );
+
+    /* control register only present on D302i */
+    if( !llHdl->d302i )
+        llHdl->useGip = 0;
+
+#ifdef Z50_D302I_ONLY
+    /* address space of this variant covers the control register */
+    llHdl->useGip = 1;
+#endif
+
+    /* Z50_EVENT_DEPTH */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, EVT_DEPTH_DEFAULT,
+                                &llHdl->evtDepth, "Z50_EVENT_DEPTH")) &&
+        error != ERR_DESC_KEY_NOTFOUND)
+        return( Cleanup(llHdl,error) );
+
+    /* alloc event ring */
+    if( llHdl->evtDepth ) {
+        if ((llHdl->evtBuf = OSS_MemGet(
+                 osHdl, llHdl->evtDepth * sizeof(Z50_EVENT),
+                 &llHdl->evtMemSize)) == NULL)
+            return( Cleanup(llHdl,ERR_OSS_MEM_ALLOC) );
+    }
+
+    /* init frequency measurement */
+    llHdl->freqGate      = FREQ_GATE_DEFAULT;
+    llHdl->freqGateTicks = msToTicks( llHdl, llHdl->freqGate );
+
+    /* Z50_TIMER_PERIOD */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, TIMER_PERIOD_DEFAULT,
+                                &llHdl->timerPeriod, "Z50_TIMER_PERIOD")) &&
+        error != ERR_DESC_KEY_NOTFOUND)
+        return( Cleanup(llHdl,error) );
+
+    if( llHdl->timerPeriod == 0 )
+        return( Cleanup(llHdl,ERR_LL_DESC_PARAM) );
+
+    /* Z50_SAMPLE_DEPTH */
+    if ((error = DESC_GetUInt32(llHdl->descHdl, SMP_DEPTH_DEFAULT,
+                                &llHdl->smpDepth, "Z50_SAMPLE_DEPTH")) &&
+        error != ERR_DESC_KEY_NOTFOUND)
+        return( Cleanup(llHdl,error) );
+
+    /* alloc sample ring */
+    if( llHdl->smpDepth ) {
+        if ((llHdl->smpBuf = OSS_MemGet(
+                 osHdl, llHdl->smpDepth * sizeof(Z50_SAMPLE),
+                 &llHdl->smpMemSize)) == NULL)
+            return( Cleanup(llHdl,ERR_OSS_MEM_ALLOC) );
+    }
+
+    llHdl->smpPeriod = 1;
+
+    /* init interrupt storm protection */
+    llHdl->quarWindow    = QUAR_WINDOW_DEFAULT;
+    llHdl->quarBackoff   = QUAR_BACKOFF_DEFAULT;
+    llHdl->quarWinTicks  = msToTmrTicks( llHdl, llHdl->quarWindow );
+    llHdl->quarBackTicks = msToTmrTicks( llHdl, llHdl->quarBackoff );
+
+    /* create semaphore for wait for edge */
+    if ((error = OSS_SemCreate(osHdl, OSS_SEM_BIN, 0, &llHdl->waitSem)))
+        return( Cleanup(llHdl,error) );
+
+    /* create driver timer and lock for timed functions */
+    if ((error = OSS_SpinLockCreate(osHdl, &llHdl->outLock)))
+        return( Cleanup(llHdl,error) );
+
+    if ((error = OSS_AlarmCreate(osHdl, alarmHandler, llHdl,
+                                 &llHdl->alarmHdl)))
+        return( Cleanup(llHdl,error) );
+
+    /* the OSS may round the period (e.g. to the system tick), all
+       conversions to timer ticks must use the real one */
+    if ((error = OSS_AlarmSet(osHdl, llHdl->alarmHdl, llHdl->timerPeriod,
+                              TRUE, &value)))
+        return( Cleanup(llHdl,error) );
+
+    OSS_AlarmClear(osHdl, llHdl->alarmHdl);
+
+    if( value && value != llHdl->timerPeriod ) {
+        DBGWRT_2((DBH, " timer period %d ms rounded to %d ms\n",
+                  llHdl->timerPeriod, value));
+        llHdl->timerPeriod = value;
+    }
+
+    /* init waveform playback */
+    llHdl->waveLoops = 1;
+
+    if ((error = OSS_SemCreate(osHdl, OSS_SEM_BIN, 0, &llHdl->waveSem)))
+        return( Cleanup(llHdl,error) );
+
     /* setup register offsets depending on kind of hardware */
     if( llHdl->d302i ) {
         llHdl->inputReg        = D302I_INPUT(0);
@@ -313,6 +706,11 @@ static int32 Z50_Exit(
 
     DBGWRT_1((DBH, "LL - Z50_Exit\n"));
 
+    /*------------------------------+
+    |  stop timed functions         |
+    +------------------------------*/
+    timerStop( llHdl, llHdl->timerUsers );
+
     /*------------------------------+
     |  de-init hardware             |
     +------------------------------*/
@@ -346,7 +744,9 @@ static int32 Z50_Read(
 {
     DBGWRT_1((DBH, "LL - Z50_Read: ch=%d\n",ch));
 
-    *valueP = MREAD_D32( llHdl->ma, llHdl->inputReg+ch*4 );
+    llHdl->stats.read++;
+
+    *valueP = MREAD_D32( llHdl->ma, REG_INPUT(llHdl)+ch*4 );
 
     return(ERR_SUCCESS);
 }
@@ -370,7 +770,11 @@ static int32 Z50_Write(
 {
     DBGWRT_1((DBH, "LL - Z50_Write: ch=%d  val=0x%x\n",ch, value));
 
-    MWRITE_D32( llHdl->ma, llHdl->outputReg+ch*4, value );
+    llHdl->stats.write++;
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+    outputSet( llHdl, ch, 0xffffffff, value );
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
 
     return(ERR_SUCCESS);
 }
@@ -405,6 +809,15 @@ static int32 Z50_SetStat(
     DBGWRT_1((DBH, "LL - Z50_SetStat: ch=%d code=0x%04x value=0x%x\n",
               ch,code,value));
 
+    llHdl->stats.setStat++;
+
+    if( (u_int32)(code - M_DEV_OF) < STAT_CODES )
+        llHdl->stats.setStatCode[code - M_DEV_OF]++;
+    else if( (u_int32)(code - M_DEV_BLK_OF) < STAT_BLK_CODES )
+        llHdl->stats.setStatBlkCode[code - M_DEV_BLK_OF]++;
+    else
+        llHdl->stats.setStatOther++;
+
     switch(code) {
         /*--------------------------+
         |  debug level              |
@@ -416,18 +829,28 @@ static int32 Z50_SetStat(
         |  enable interrupts        |
         +--------------------------*/
         case M_MK_IRQ_ENABLE:
-            if( value == 0 ) {
+            /* D302i: use global interrupt enable */
+            if( USE_GIP(llHdl) ) {
+                if( value )
+                    MSETMASK_D32( ma, D302I_CTRL, D302I_CTRL_GIEN );
+                else
+                    MCLRMASK_D32( ma, D302I_CTRL, D302I_CTRL_GIEN );
+            }
+            else if( value == 0 ) {
                 int i, numRegs;
 
-                numRegs = (llHdl->d302i) ? CH_NUMBER : 1;
+                numRegs = NUM_REGS(llHdl);
 
                 /* for all registers */
                 for( i=0; i<numRegs; ++i ) {
 
                     /* disable all interrupts */
-                    MWRITE_D32( ma, llHdl->irqEdgeRaiseReg+i*4, 0 );
-                    MWRITE_D32( ma, llHdl->irqEdgeFallReg+i*4, 0 );
+                    llHdl->reqIrqRaise[i] = llHdl->reqIrqFall[i] = 0;
+                    llHdl->shIrqRaise[i] = llHdl->shIrqFall[i] = 0;
+                    MWRITE_D32( ma, REG_IRQ_EDGE_RAISE(llHdl)+i*4, 0 );
+                    MWRITE_D32( ma, REG_IRQ_EDGE_FALL(llHdl)+i*4, 0 );
                 }
+                llHdl->irqChMask = 0;
             }
             break;
 
@@ -451,28 +874,198 @@ static int32 Z50_SetStat(
         |  set IO ports             |
         +--------------------------*/
         case Z50_SET_PORTS:
-            MSETMASK_D32( ma, llHdl->outputReg+ch*4, value );
+            OSS_SpinLockAcquire( OSH, llHdl->outLock );
+            outputSet( llHdl, ch, value, 0xffffffff );
+            OSS_SpinLockRelease( OSH, llHdl->outLock );
             break;
 
         /*--------------------------+
         |  clear IO ports           |
         +--------------------------*/
         case Z50_CLR_PORTS:
-            MCLRMASK_D32( ma, llHdl->outputReg+ch*4, value );
+            OSS_SpinLockAcquire( OSH, llHdl->outLock );
+            outputSet( llHdl, ch, value, 0 );
+            OSS_SpinLockRelease( OSH, llHdl->outLock );
             break;
 
         /*--------------------------+
         |  irq on rising edge       |
         +--------------------------*/
         case Z50_IRQ_EDGE_RAISE:
-            MWRITE_D32( ma, llHdl->irqEdgeRaiseReg+ch*4, value );
+        {
+            OSS_IRQ_STATE irqState;
+
+            /* quarantined inputs stay masked */
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+            llHdl->reqIrqRaise[ch] = value;
+            llHdl->shIrqRaise[ch] = value & ~llHdl->quarMask[ch];
+            MWRITE_D32( ma, REG_IRQ_EDGE_RAISE(llHdl)+ch*4,
+                        llHdl->shIrqRaise[ch] );
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+
+            irqChMaskUpdate( llHdl, ch );
             break;
+        }
 
         /*--------------------------+
         |  irq on falling edge      |
         +--------------------------*/
         case Z50_IRQ_EDGE_FALL:
-            MWRITE_D32( ma, llHdl->irqEdgeFallReg+ch*4, value );
+        {
+            OSS_IRQ_STATE irqState;
+
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+            llHdl->reqIrqFall[ch] = value;
+            llHdl->shIrqFall[ch] = value & ~llHdl->quarMask[ch];
+            MWRITE_D32( ma, REG_IRQ_EDGE_FALL(llHdl)+ch*4,
+                        llHdl->shIrqFall[ch] );
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+
+            irqChMaskUpdate( llHdl, ch );
+            break;
+        }
+
+        /*--------------------------+
+        |  frequency measurement    |
+        +--------------------------*/
+        case Z50_FREQ_INPUTS:
+        {
+            OSS_IRQ_STATE irqState;
+            u_int32 newBits = value & ~llHdl->freqMask[ch];
+            int i;
+
+            /* OSS tick would quantize periods to milliseconds */
+            if( value && !TS_FINE() ) {
+                error = ERR_LL_ILL_FUNC;
+                break;
+            }
+
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+            /* start newly enabled inputs from scratch */
+            for( i=0; i<IN_NUMBER; ++i ) {
+                if( newBits & ((u_int32)1 << i) )
+                    OSS_MemFill( OSH, sizeof(FREQ_IN),
+                                 (char*)&llHdl->freq[ch][i], 0 );
+            }
+            llHdl->freqMask[ch] = value;
+
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        case Z50_FREQ_GATE:
+            if( value <= 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            llHdl->freqGate      = value;
+            llHdl->freqGateTicks = msToTicks( llHdl, value );
+            break;
+
+        /*--------------------------+
+        |  M_setblock function      |
+        +--------------------------*/
+        case Z50_SETBLOCK_MODE:
+            if( value != Z50_SBM_OUTPUT && value != Z50_SBM_WAVE ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            llHdl->sbMode = value;
+            break;
+
+        /*--------------------------+
+        |  waveform playback        |
+        +--------------------------*/
+        case Z50_WAVE_LOOPS:
+            if( value < 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            llHdl->waveLoops = value;
+            break;
+
+        case Z50_WAVE_STOP:
+            OSS_SpinLockAcquire( OSH, llHdl->outLock );
+            if( llHdl->waveState == Z50_WAVE_RUNNING ) {
+                llHdl->waveState = Z50_WAVE_IDLE;
+                OSS_SemSignal( OSH, llHdl->waveSem );
+            }
+            OSS_SpinLockRelease( OSH, llHdl->outLock );
+            timerStop( llHdl, TMR_WAVE );
+            break;
+
+        case Z50_WAVE_SIGNAL:
+        {
+            OSS_SIG_HANDLE *sig = NULL, *oldSig;
+
+            if( value && (error = OSS_SigCreate( OSH, value, &sig )) )
+                break;
+
+            /* waveTick() may send the old signal */
+            OSS_SpinLockAcquire( OSH, llHdl->outLock );
+            oldSig = llHdl->waveSig;
+            llHdl->waveSig = sig;
+            OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+            if( oldSig )
+                OSS_SigRemove( OSH, &oldSig );
+            break;
+        }
+
+        /*--------------------------+
+        |  software PWM             |
+        +--------------------------*/
+        case Z50_BLK_PWM:
+            if( blk->size < (int32)sizeof(Z50_PWM_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            error = pwmSet( llHdl, ch, (Z50_PWM_PB*)blk->data );
+            break;
+
+        /*--------------------------+
+        |  M_getblock function      |
+        +--------------------------*/
+        case Z50_GETBLOCK_MODE:
+            if( value != Z50_GBM_INPUT && value != Z50_GBM_SAMPLE ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            llHdl->gbMode = value;
+            break;
+
+        /*--------------------------+
+        |  input sampling           |
+        +--------------------------*/
+        case Z50_SAMPLE_PERIOD:
+            if( value <= 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            OSS_SpinLockAcquire( OSH, llHdl->outLock );
+            llHdl->smpPeriod = msToTmrTicks( llHdl, value );
+            OSS_SpinLockRelease( OSH, llHdl->outLock );
+            break;
+
+        case Z50_SAMPLE_FORMAT:
+            if( value != Z50_SMP_RAW && value != Z50_SMP_RLE ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            if( llHdl->smpOn ) {
+                error = ERR_LL_DEV_BUSY;
+                break;
+            }
+            llHdl->smpFormat = value;
+            break;
+
+        case Z50_SAMPLING:
+            if( value )
+                error = sampleStart( llHdl, ch );
+            else
+                sampleStop( llHdl );
             break;
 
         /*--------------------------+
@@ -482,12 +1075,24 @@ static int32 Z50_SetStat(
         {
             Z50_DEBOUNCE_PB *pb = (Z50_DEBOUNCE_PB*)blk->data;
 
+            if( blk->size < (int32)sizeof(Z50_DEBOUNCE_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
             /* ignore pb->input on D302I, use channel number instead */
-            if( llHdl->d302i ) {
-                MWRITE_D32( ma, llHdl->debounceReg + ch*4, pb->time );
+            if( IS_D302I(llHdl) ) {
+                llHdl->shDebounce[ch] = pb->time;
+                MWRITE_D32( ma, REG_DEBOUNCE(llHdl) + ch*4, pb->time );
             }
             else {
-                MWRITE_D32( ma, llHdl->debounceReg + (pb->input)*4, pb->time );
+                if( pb->input < 0 || pb->input >= DEBOUNCE_NUMBER ) {
+                    error = ERR_LL_ILL_PARAM;
+                    break;
+                }
+                llHdl->shDebounce[pb->input] = pb->time;
+                MWRITE_D32( ma, REG_DEBOUNCE(llHdl) + (pb->input)*4,
+                            pb->time );
             }
 
             break;
@@ -521,6 +1126,92 @@ static int32 Z50_SetStat(
             error = OSS_SigRemove( OSH, &llHdl->portChangeSig );
             break;
 
+        /*--------------------------+
+        |  notification coalescing  |
+        +--------------------------*/
+        case Z50_NOTIFY_HOLDOFF:
+        {
+            OSS_IRQ_STATE irqState;
+
+            if( value < 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+            llHdl->ntfHoldoff      = value;
+            llHdl->ntfHoldoffTicks = value ? msToTicks( llHdl, value ) : 0;
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+
+            /* timer sends signals deferred by holdoff */
+            if( value )
+                error = timerStart( llHdl, TMR_NOTIFY );
+            else
+                timerStop( llHdl, TMR_NOTIFY );
+            break;
+        }
+
+        case Z50_NOTIFY_THRESHOLD:
+            if( value < 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            llHdl->ntfThreshold = value;
+            break;
+
+        /*--------------------------+
+        |  interrupt storm protect. |
+        +--------------------------*/
+        case Z50_QUAR_THRESHOLD:
+            if( value < 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            error = quarSet( llHdl, value );
+            break;
+
+        case Z50_QUAR_WINDOW:
+            if( value <= 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            OSS_SpinLockAcquire( OSH, llHdl->outLock );
+            llHdl->quarWindow   = value;
+            llHdl->quarWinTicks = msToTmrTicks( llHdl, value );
+            OSS_SpinLockRelease( OSH, llHdl->outLock );
+            break;
+
+        case Z50_QUAR_BACKOFF:
+            if( value <= 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+            OSS_SpinLockAcquire( OSH, llHdl->outLock );
+            llHdl->quarBackoff   = value;
+            llHdl->quarBackTicks = msToTmrTicks( llHdl, value );
+            OSS_SpinLockRelease( OSH, llHdl->outLock );
+            break;
+
+        /*--------------------------+
+        |  interrupt timing         |
+        +--------------------------*/
+        case Z50_HISTOGRAM:
+        {
+            OSS_IRQ_STATE irqState;
+
+            /* OSS tick would put nearly all values into bucket 0 */
+            if( value && !TS_FINE() ) {
+                error = ERR_LL_ILL_FUNC;
+                break;
+            }
+
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+            llHdl->histOn = value ? TRUE : FALSE;
+            llHdl->histIrqSeen = FALSE;
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
         /*--------------------------+
         |  (unknown)                |
         +--------------------------*/
@@ -554,7 +1245,6 @@ static int32 Z50_GetStat(
     INT32_OR_64 *value32_or_64P
 )
 {
-    MACCESS ma = llHdl->ma;
     int32 error = ERR_SUCCESS;
     int32       *valueP = (int32*)value32_or_64P; /* pointer to 32bit value  */
     INT32_OR_64 *value64P = value32_or_64P;       /* stores 32/64bit pointer  */
@@ -563,6 +1253,8 @@ static int32 Z50_GetStat(
     DBGWRT_1((DBH, "LL - Z50_GetStat: ch=%d code=0x%04x\n",
               ch,code));
 
+    llHdl->stats.getStat++;
+
     switch(code)
     {
         /*--------------------------+
@@ -575,7 +1267,7 @@ static int32 Z50_GetStat(
         |  number of channels       |
         +--------------------------*/
         case M_LL_CH_NUMBER:
-            if( llHdl->d302i ) {
+            if( IS_D302I(llHdl) ) {
                 *valueP = CH_NUMBER;
             }
             else {
@@ -626,24 +1318,9 @@ static int32 Z50_GetStat(
         case Z50_EDGE_RAISE:
         {
             OSS_IRQ_STATE irqState;
-            u_int32 bitsNotFromIrq;
 
-            /* disable interrupts */
             irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
-
-            /*
-             * combine bits:
-             *  - which are set set by irq routine
-             *  - from inputs not causing irqs
-             */
-            bitsNotFromIrq = MREAD_D32( ma, llHdl->edgeRaiseReg + ch*4) &
-                ~MREAD_D32( ma, llHdl->irqEdgeRaiseReg + ch*4);
-
-            *valueP = llHdl->edgeRaiseIrq[ch] | bitsNotFromIrq;
-
-            /* clear bits for next request */
-            MWRITE_D32( ma, llHdl->edgeRaiseReg, bitsNotFromIrq );
-            llHdl->edgeRaiseIrq[ch] = 0;
+            edgeGet( llHdl, ch, (u_int32*)valueP, NULL );
             OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
             break;
         }
@@ -654,20 +1331,10 @@ static int32 Z50_GetStat(
         case Z50_EDGE_FALL:
         {
             OSS_IRQ_STATE irqState;
-            u_int32 bitsNotFromIrq;
-
-            /* see code for rising edge */
 
             irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
-            bitsNotFromIrq = MREAD_D32( ma, llHdl->edgeFallReg + ch*4) &
-                ~MREAD_D32( ma, llHdl->irqEdgeFallReg + ch*4);
-
-            *valueP = llHdl->edgeFallIrq[ch] | bitsNotFromIrq;
-
-            MWRITE_D32( ma, llHdl->edgeFallReg, bitsNotFromIrq );
-            llHdl->edgeFallIrq[ch] = 0;
+            edgeGet( llHdl, ch, NULL, (u_int32*)valueP );
             OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
-
             break;
         }
 
@@ -675,55 +1342,542 @@ static int32 Z50_GetStat(
         |  irq on raising edge      |
         +--------------------------*/
         case Z50_IRQ_EDGE_RAISE:
-            *valueP = MREAD_D32( ma, llHdl->irqEdgeRaiseReg+ch*4 );
+            *valueP = llHdl->reqIrqRaise[ch];
             break;
 
         /*--------------------------+
         |  irq on falling edge      |
         +--------------------------*/
         case Z50_IRQ_EDGE_FALL:
-            *valueP = MREAD_D32( ma, llHdl->irqEdgeFallReg+ch*4 );
+            *valueP = llHdl->reqIrqFall[ch];
             break;
 
         /*--------------------------+
-        |  debouncer                |
+        |  verify shadow registers  |
         +--------------------------*/
-        case Z50_BLK_DEBOUNCE:
-        {
-            Z50_DEBOUNCE_PB *pb = (Z50_DEBOUNCE_PB*)blk->data;
+        case Z50_SHADOW_CHECK:
+            *valueP = shadowCheck( llHdl );
+            break;
 
-            /* ignore pb->input on D302I, use channel number instead */
-            if( llHdl->d302i ) {
-                pb->time = MREAD_D32( ma, llHdl->debounceReg + ch*4 );
-            }
-            else {
-                pb->time = MREAD_D32( ma, llHdl->debounceReg + (pb->input)*4 );
-            }
+        /*--------------------------+
+        |  frequency measurement    |
+        +--------------------------*/
+        case Z50_FREQ_INPUTS:
+            *valueP = llHdl->freqMask[ch];
+            break;
 
+        case Z50_FREQ_GATE:
+            *valueP = llHdl->freqGate;
             break;
-        }
 
         /*--------------------------+
-        |  (unknown)                |
+        |  M_setblock function      |
         +--------------------------*/
-        default:
-            error = ERR_LL_UNK_CODE;
-    }
+        case Z50_SETBLOCK_MODE:
+            *valueP = llHdl->sbMode;
+            break;
 
-    return(error);
-}
+        /*--------------------------+
+        |  waveform playback        |
+        +--------------------------*/
+        case Z50_WAVE_LOOPS:
+            *valueP = llHdl->waveLoops;
+            break;
 
-/******************************* Z50_BlockRead ******************************/
-/** Read a data block from the device
- *
- *  \param llHdl       \IN  low-level handle
- *  \param ch          \IN  current channel
- *  \param buf         \IN  data buffer
- *  \param size        \IN  data buffer size
- *  \param nbrRdBytesP \OUT number of read bytes
- *
- *  \return            \c 0 on success or error code
- */
+        case Z50_TIMER_TICK:
+            *valueP = llHdl->timerPeriod;
+            break;
+
+        case Z50_WAVE_STATE:
+            *valueP = llHdl->waveState;
+            break;
+
+        case Z50_BLK_WAVE_WAIT:
+            if( blk->size < (int32)sizeof(Z50_WAVE_WAIT_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            error = waveWaitEnd( llHdl, (Z50_WAVE_WAIT_PB*)blk->data );
+            break;
+
+        /*--------------------------+
+        |  software PWM             |
+        +--------------------------*/
+        case Z50_PWM_OUTPUTS:
+            *valueP = llHdl->pwmMask[ch];
+            break;
+
+        case Z50_BLK_PWM:
+        {
+            Z50_PWM_PB *pb = (Z50_PWM_PB*)blk->data;
+            u_int32 usPerTick = llHdl->timerPeriod * 1000;
+            int i;
+
+            if( blk->size < (int32)sizeof(Z50_PWM_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            if( pb->mask == 0 ) {
+                error = ERR_LL_ILL_PARAM;
+                break;
+            }
+
+            /* lowest bit selects output */
+            for( i=0; !(pb->mask & ((u_int32)1 << i)); ++i )
+                ;
+
+            if( llHdl->pwmMask[ch] & ((u_int32)1 << i) ) {
+                pb->period = llHdl->pwmPeriod[ch][i] * usPerTick;
+                pb->duty   = llHdl->pwmDuty[ch][i] * usPerTick;
+            }
+            else {
+                pb->period = pb->duty = 0;
+            }
+            break;
+        }
+
+        /*--------------------------+
+        |  M_getblock function      |
+        +--------------------------*/
+        case Z50_GETBLOCK_MODE:
+            *valueP = llHdl->gbMode;
+            break;
+
+        /*--------------------------+
+        |  input sampling           |
+        +--------------------------*/
+        case Z50_SAMPLE_PERIOD:
+            *valueP = llHdl->smpPeriod * llHdl->timerPeriod;
+            break;
+
+        case Z50_SAMPLING:
+            *valueP = llHdl->smpOn;
+            break;
+
+        case Z50_SAMPLE_FORMAT:
+            *valueP = llHdl->smpFormat;
+            break;
+
+        /*--------------------------+
+        |  notification coalescing  |
+        +--------------------------*/
+        case Z50_NOTIFY_HOLDOFF:
+            *valueP = llHdl->ntfHoldoff;
+            break;
+
+        case Z50_NOTIFY_THRESHOLD:
+            *valueP = llHdl->ntfThreshold;
+            break;
+
+        /*--------------------------+
+        |  interrupt storm protect. |
+        +--------------------------*/
+        case Z50_QUAR_THRESHOLD:
+            *valueP = llHdl->quarThreshold;
+            break;
+
+        case Z50_QUAR_WINDOW:
+            *valueP = llHdl->quarWindow;
+            break;
+
+        case Z50_QUAR_BACKOFF:
+            *valueP = llHdl->quarBackoff;
+            break;
+
+        case Z50_QUAR_INPUTS:
+            *valueP = llHdl->quarMask[ch];
+            break;
+
+        case Z50_BLK_QUARANTINE:
+        {
+            Z50_QUAR_PB *pb = (Z50_QUAR_PB*)blk->data;
+            OSS_IRQ_STATE irqState;
+            int i;
+
+            if( blk->size < (int32)sizeof(Z50_QUAR_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            pb->numCh = NUM_REGS(llHdl);
+
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+            for( i=0; i<CH_NUMBER; ++i )
+                pb->mask[i] = llHdl->quarMask[i];
+
+            OSS_MemCopy( OSH, sizeof(pb->count), (char*)llHdl->quarTotal,
+                         (char*)pb->count );
+
+            if( pb->reset == 1 )
+                OSS_MemFill( OSH, sizeof(llHdl->quarTotal),
+                             (char*)llHdl->quarTotal, 0 );
+
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        /*--------------------------+
+        |  interrupt timing         |
+        +--------------------------*/
+        case Z50_HISTOGRAM:
+            *valueP = llHdl->histOn;
+            break;
+
+        case Z50_BLK_HIST:
+        {
+            Z50_HIST_PB *pb = (Z50_HIST_PB*)blk->data;
+            OSS_IRQ_STATE irqState;
+
+            if( !TS_FINE() ) {
+                error = ERR_LL_ILL_FUNC;
+                break;
+            }
+
+            if( blk->size < (int32)sizeof(Z50_HIST_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            pb->tickRate = Z50_TIMESTAMP_RATE();
+
+            /* copy (and reset) all histograms at once */
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+            OSS_MemCopy( OSH, sizeof(HIST), (char*)&llHdl->histIsr,
+                         (char*)&pb->isrTime );
+            OSS_MemCopy( OSH, sizeof(HIST), (char*)&llHdl->histNtf,
+                         (char*)&pb->ntfDelay );
+            OSS_MemCopy( OSH, sizeof(HIST), (char*)&llHdl->histGap,
+                         (char*)&pb->irqGap );
+
+            if( pb->reset == 1 ) {
+                OSS_MemFill( OSH, sizeof(HIST), (char*)&llHdl->histIsr, 0 );
+                OSS_MemFill( OSH, sizeof(HIST), (char*)&llHdl->histNtf, 0 );
+                OSS_MemFill( OSH, sizeof(HIST), (char*)&llHdl->histGap, 0 );
+            }
+
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        /*--------------------------+
+        |  statistics               |
+        +--------------------------*/
+        case Z50_BLK_STATS:
+        {
+            Z50_STATS_PB *pb = (Z50_STATS_PB*)blk->data;
+            OSS_IRQ_STATE irqState;
+
+            if( blk->size < (int32)sizeof(Z50_STATS_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+            OSS_MemCopy( OSH, sizeof(STATS), (char*)&llHdl->stats,
+                         (char*)&pb->stats );
+
+            if( pb->reset == 1 )
+                OSS_MemFill( OSH, sizeof(STATS), (char*)&llHdl->stats, 0 );
+
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        /*--------------------------+
+        |  debouncer                |
+        +--------------------------*/
+        case Z50_BLK_DEBOUNCE:
+        {
+            Z50_DEBOUNCE_PB *pb = (Z50_DEBOUNCE_PB*)blk->data;
+
+            if( blk->size < (int32)sizeof(Z50_DEBOUNCE_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            /* ignore pb->input on D302I, use channel number instead */
+            if( IS_D302I(llHdl) ) {
+                pb->time = llHdl->shDebounce[ch];
+            }
+            else {
+                if( pb->input < 0 || pb->input >= DEBOUNCE_NUMBER ) {
+                    error = ERR_LL_ILL_PARAM;
+                    break;
+                }
+                pb->time = llHdl->shDebounce[pb->input];
+            }
+
+            break;
+        }
+
+        /*--------------------------+
+        |  edge events              |
+        +--------------------------*/
+        case Z50_BLK_EVENTS:
+        {
+            Z50_EVENT_HDR *hdr = (Z50_EVENT_HDR*)blk->data;
+            Z50_EVENT *evt = (Z50_EVENT*)(hdr+1);
+            OSS_IRQ_STATE irqState;
+            u_int32 n, out;
+
+            if( llHdl->evtDepth == 0 ) {
+                error = ERR_LL_ILL_FUNC;
+                break;
+            }
+
+            if( blk->size < (int32)sizeof(Z50_EVENT_HDR) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            /* number of records fitting into user buffer */
+            n = (blk->size - sizeof(Z50_EVENT_HDR)) / sizeof(Z50_EVENT);
+
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+            if( n > llHdl->evtCount )
+                n = llHdl->evtCount;
+
+            /* index of oldest record */
+            out = (llHdl->evtIn + llHdl->evtDepth - llHdl->evtCount) %
+                llHdl->evtDepth;
+
+            hdr->count     = n;
+            hdr->pending   = llHdl->evtCount - n;
+            hdr->lost      = llHdl->evtLost;
+            hdr->lostTotal = llHdl->evtLostTotal;
+            hdr->tickRate  = Z50_TIMESTAMP_RATE();
+
+            llHdl->evtCount -= n;
+            llHdl->evtLost = 0;
+
+            while( n-- ) {
+                *evt++ = ((Z50_EVENT*)llHdl->evtBuf)[out];
+                if( ++out == llHdl->evtDepth )
+                    out = 0;
+            }
+
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        /*--------------------------+
+        |  wait for edge            |
+        +--------------------------*/
+        case Z50_BLK_WAIT_EDGE:
+            if( blk->size < (int32)sizeof(Z50_WAIT_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            error = waitEdge( llHdl, ch, (Z50_WAIT_PB*)blk->data );
+            break;
+
+        /*--------------------------+
+        |  edge counters            |
+        +--------------------------*/
+        case Z50_BLK_EDGE_COUNT:
+        {
+            Z50_EDGE_COUNT_PB *pb = (Z50_EDGE_COUNT_PB*)blk->data;
+            OSS_IRQ_STATE irqState;
+
+            if( blk->size < (int32)sizeof(Z50_EDGE_COUNT_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            pb->numCh = NUM_REGS(llHdl);
+
+            /* copy (and reset) all counters at once */
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+            OSS_MemCopy( OSH, sizeof(llHdl->edgeCntRaise),
+                         (char*)llHdl->edgeCntRaise, (char*)pb->raise );
+            OSS_MemCopy( OSH, sizeof(llHdl->edgeCntFall),
+                         (char*)llHdl->edgeCntFall, (char*)pb->fall );
+
+            if( pb->reset ) {
+                OSS_MemFill( OSH, sizeof(llHdl->edgeCntRaise),
+                             (char*)llHdl->edgeCntRaise, 0 );
+                OSS_MemFill( OSH, sizeof(llHdl->edgeCntFall),
+                             (char*)llHdl->edgeCntFall, 0 );
+            }
+
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        /*--------------------------+
+        |  edges of all channels    |
+        +--------------------------*/
+        case Z50_BLK_EDGE_ALL:
+        {
+            Z50_EDGE_ALL_PB *pb = (Z50_EDGE_ALL_PB*)blk->data;
+            OSS_IRQ_STATE irqState;
+            int32 i;
+
+            if( blk->size < (int32)sizeof(Z50_EDGE_ALL_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            pb->numCh = NUM_REGS(llHdl);
+
+            /* one consistent snapshot of all channels */
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+            for( i=0; i<Z50_MAX_CH; i++ ) {
+                if( i < NUM_REGS(llHdl) )
+                    edgeGet( llHdl, i, &pb->raise[i], &pb->fall[i] );
+                else
+                    pb->raise[i] = pb->fall[i] = 0;
+            }
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        /*--------------------------+
+        |  inputs and edges         |
+        +--------------------------*/
+        case Z50_BLK_STATUS:
+        {
+            Z50_STATUS_PB *pb = (Z50_STATUS_PB*)blk->data;
+            OSS_IRQ_STATE irqState;
+
+            if( blk->size < (int32)sizeof(Z50_STATUS_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            /* same as M_read() + Z50_EDGE_RAISE/FALL + M_LL_IRQ_COUNT */
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+            pb->input = MREAD_D32( llHdl->ma, REG_INPUT(llHdl)+ch*4 );
+            edgeGet( llHdl, ch, &pb->raise, &pb->fall );
+            pb->irqCount = llHdl->irqCount;
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        /*--------------------------+
+        |  layout for user mapping  |
+        +--------------------------*/
+        case Z50_BLK_LAYOUT:
+        {
+            Z50_LAYOUT_PB *pb = (Z50_LAYOUT_PB*)blk->data;
+
+            if( blk->size < (int32)sizeof(Z50_LAYOUT_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            pb->hwType   = IS_D302I(llHdl) ? Z50_HW_D302I : Z50_HW_BIOC;
+            pb->numCh    = NUM_REGS(llHdl);
+            pb->size     = ADDRSPACE_SIZE;
+            pb->input    = REG_INPUT(llHdl);
+            pb->output   = REG_OUTPUT(llHdl);
+            pb->chStride = IS_D302I(llHdl) ? 4 : 0;
+            break;
+        }
+
+        /*--------------------------+
+        |  frequency results        |
+        +--------------------------*/
+        case Z50_BLK_FREQ:
+        {
+            Z50_FREQ_PB *pb = (Z50_FREQ_PB*)blk->data;
+            OSS_IRQ_STATE irqState;
+            FREQ_IN *f;
+            Z50_FREQ *res;
+            u_int32 now, rate, idle;
+            int i, n;
+
+            if( !TS_FINE() ) {
+                error = ERR_LL_ILL_FUNC;
+                break;
+            }
+
+            if( blk->size < (int32)sizeof(Z50_FREQ_PB) ) {
+                error = ERR_LL_USERBUF;
+                break;
+            }
+
+            rate = Z50_TIMESTAMP_RATE();
+            pb->numCh    = NUM_REGS(llHdl);
+            pb->tickRate = rate;
+
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+            now = Z50_TIMESTAMP();
+
+            for( i=0; i<CH_NUMBER; ++i ) {
+                for( n=0; n<IN_NUMBER; ++n ) {
+                    f   = &llHdl->freq[i][n];
+                    res = &pb->in[i][n];
+
+                    res->period      = f->period;
+                    res->minPeriod   = f->minPeriod;
+                    res->maxPeriod   = f->maxPeriod;
+                    res->gatePeriods = f->resPeriods;
+                    res->gateTime    = f->resTime;
+
+                    /* signal stopped ? (no edge for gate and 2 periods) */
+                    idle = now - f->lastTime;
+                    if( !f->valid || (idle > llHdl->freqGateTicks &&
+                                      idle > 2*f->period) ) {
+                        res->gatePeriods = 0;
+                    }
+
+                    res->freq = res->gateTime ?
+                        mulDiv( res->gatePeriods, rate, res->gateTime ) : 0;
+
+                    if( pb->reset ) {
+                        f->minPeriod = 0;
+                        f->maxPeriod = 0;
+                    }
+                }
+            }
+
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+
+        /*--------------------------+
+        |  (unknown)                |
+        +--------------------------*/
+        default:
+            error = ERR_LL_UNK_CODE;
+    }
+
+    return(error);
+}
+
+/******************************* Z50_BlockRead ******************************/
+/** Read a data block from the device
+ *
+ *  In mode Z50_GBM_INPUT (default) the function reads the input registers
+ *  of all channels (D302i: four, BIOC: one) and stores them as u_int32
+ *  values into the buffer, channel 0 first. The current channel is
+ *  ignored.
+ *
+ *  The registers are read back-to-back with the device interrupt masked,
+ *  so the returned input image is consistent. If the buffer is too small
+ *  for all channels, only the first \a size/4 channels are read.
+ *
+ *  In mode Z50_GBM_SAMPLE the function drains the sample ring: the
+ *  buffer receives a Z50_SAMPLE_HDR followed by as many Z50_SAMPLE
+ *  records as fit.
+ *
+ *  \param llHdl       \IN  low-level handle
+ *  \param ch          \IN  current channel
+ *  \param buf         \IN  data buffer
+ *  \param size        \IN  data buffer size
+ *  \param nbrRdBytesP \OUT number of read bytes
+ *
+ *  \return            \c 0 on success or error code
+ */
 static int32 Z50_BlockRead(
      LL_HANDLE *llHdl,
      int32     ch,
@@ -732,322 +1886,1789 @@ static int32 Z50_BlockRead(
      int32     *nbrRdBytesP
 )
 {
-    DBGWRT_1((DBH, "LL - Z50_BlockRead: ch=%d, size=%d\n",ch,size));
+    MACCESS ma = llHdl->ma;
+    OSS_IRQ_STATE irqState;
+    u_int32 *dataP = (u_int32*)buf;
+    int32 i, numRegs;
+
+    (void)ch;
+
+    DBGWRT_1((DBH, "LL - Z50_BlockRead: ch=%d, size=%d\n",ch,size));
+
+    llHdl->stats.blockRead++;
+
+    /* return number of read bytes */
+    *nbrRdBytesP = 0;
+
+    if( llHdl->gbMode == Z50_GBM_SAMPLE )
+        return( sampleRead( llHdl, buf, size, nbrRdBytesP ) );
+
+    numRegs = NUM_REGS(llHdl);
+
+    /* limit to user buffer */
+    if( numRegs > size/4 )
+        numRegs = size/4;
+
+    if( numRegs == 0 )
+        return( ERR_LL_USERBUF );
+
+    /* take snapshot of all input registers */
+    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+    for( i=0; i<numRegs; ++i )
+        dataP[i] = MREAD_D32( ma, REG_INPUT(llHdl)+i*4 );
+
+    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+
+    *nbrRdBytesP = numRegs*4;
+
+    return( ERR_SUCCESS );
+}
+
+/****************************** Z50_BlockWrite *****************************/
+/** Write a data block to the device
+ *
+ *  In mode Z50_SBM_OUTPUT (default) the function writes the output
+ *  registers of all channels (D302i: four, BIOC: one). The buffer holds
+ *  one u_int32 output value per channel, channel 0 first. The current
+ *  channel is ignored.
+ *
+ *  The registers are written back-to-back with the output lock held, so
+ *  neither another driver entry point nor a timed function can run in
+ *  between and the outputs never show a partially updated image. If the
+ *  buffer holds less values than channels, only the first \a size/4
+ *  channels are written.
+ *
+ *  In mode Z50_SBM_WAVE the buffer contains Z50_WAVE_STEP records which
+ *  are played back on the current channel by the driver timer.
+ *
+ *  \param llHdl       \IN  low-level handle
+ *  \param ch          \IN  current channel
+ *  \param buf         \IN  data buffer
+ *  \param size        \IN  data buffer size
+ *  \param nbrWrBytesP \OUT number of written bytes
+ *
+ *  \return            \c 0 on success or error code
+ */
+static int32 Z50_BlockWrite(
+     LL_HANDLE *llHdl,
+     int32     ch,
+     void      *buf,
+     int32     size,
+     int32     *nbrWrBytesP
+)
+{
+    u_int32 *dataP = (u_int32*)buf;
+    int32 i, numRegs;
+
+    DBGWRT_1((DBH, "LL - Z50_BlockWrite: ch=%d, size=%d\n",ch,size));
+
+    llHdl->stats.blockWrite++;
+
+    /* return number of written bytes */
+    *nbrWrBytesP = 0;
+
+    if( llHdl->sbMode == Z50_SBM_WAVE )
+        return( waveStart( llHdl, ch, buf, size, nbrWrBytesP ) );
+
+    numRegs = NUM_REGS(llHdl);
+
+    /* limit to user buffer */
+    if( numRegs > size/4 )
+        numRegs = size/4;
+
+    if( numRegs == 0 )
+        return( ERR_LL_USERBUF );
+
+    /* update all output registers at once */
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+
+    for( i=0; i<numRegs; ++i )
+        outputSet( llHdl, i, 0xffffffff, dataP[i] );
+
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+    *nbrWrBytesP = numRegs*4;
+
+    return( ERR_SUCCESS );
+}
+
+
+/****************************** Z50_Irq ************************************/
+/** Interrupt service routine
+ *
+ *  The interrupt is triggered when one or more input ports change state.
+ *  Depends on current setting via Z16_IRQ_SENSE.
+ *
+ *  If the driver can detect the interrupt's cause it returns
+ *  LL_IRQ_DEVICE or LL_IRQ_DEV_NOT, otherwise LL_IRQ_UNKNOWN.
+ *
+ *  \param llHdl       \IN  low-level handle
+ *  \return LL_IRQ_DEVICE   irq caused by device
+ *          LL_IRQ_DEV_NOT  irq not caused by device
+ *          LL_IRQ_UNKNOWN  unknown
+ */
+static int32 Z50_Irq(
+    LL_HANDLE *llHdl
+)
+{
+    MACCESS ma = llHdl->ma;
+    u_int8  myIrq=0, i, numRegs;
+    u_int32 inputsCausingIrqRaise=0, inputsCausingIrqFall=0;
+    u_int32 now, edges=0, input=0;
+
+    IDBGWRT_1((DBH, ">>> Z50_Irq:\n"));
+
+    /* no interrupt enabled on any channel ? */
+    if( llHdl->irqChMask == 0 ) {
+        llHdl->stats.irqNotOwn++;
+        return( LL_IRQ_DEV_NOT );
+    }
+
+    /* D302i: nothing pending ? */
+    if( USE_GIP(llHdl) &&
+        !(MREAD_D32( ma, D302I_CTRL ) & D302I_CTRL_GIP) ) {
+        llHdl->stats.irqNotOwn++;
+        return( LL_IRQ_DEV_NOT );
+    }
+
+    now = Z50_TIMESTAMP();
+
+    /* how many registers to handle ? */
+    numRegs = NUM_REGS(llHdl);
+
+    for( i=0; i<numRegs; ++i ) {
+        /* skip channels without enabled interrupts */
+        if( !(llHdl->irqChMask & (1<<i)) )
+            continue;
+
+        /* for raising edge: get mask of inputs which caused irq */
+        inputsCausingIrqRaise = 0;
+
+        if( llHdl->shIrqRaise[i] ) {
+            inputsCausingIrqRaise =
+                MREAD_D32( ma, REG_EDGE_RAISE(llHdl)+i*4 ) &
+                llHdl->shIrqRaise[i];
+
+            if( inputsCausingIrqRaise ) {
+                /* clear irq by setting corresponding bits */
+                MWRITE_D32( ma, REG_EDGE_RAISE(llHdl)+i*4,
+                            inputsCausingIrqRaise );
+
+                /* save bits for user */
+                llHdl->edgeRaiseIrq[i] |= inputsCausingIrqRaise;
+            }
+        }
+
+        /* same for falling edge */
+        inputsCausingIrqFall = 0;
+
+        if( llHdl->shIrqFall[i] ) {
+            inputsCausingIrqFall =
+                MREAD_D32( ma, REG_EDGE_FALL(llHdl)+i*4 ) &
+                llHdl->shIrqFall[i];
+
+            if( inputsCausingIrqFall ) {
+                MWRITE_D32( ma, REG_EDGE_FALL(llHdl)+i*4,
+                            inputsCausingIrqFall );
+                llHdl->edgeFallIrq[i] |= inputsCausingIrqFall;
+            }
+        }
+
+        /* this interrupt caused by GPIO controller ? */
+        if( inputsCausingIrqRaise || inputsCausingIrqFall ) {
+            myIrq = 1;
+
+            /* mask inputs exceeding the edge rate */
+            if( llHdl->quarThreshold )
+                quarCheck( llHdl, i,
+                           inputsCausingIrqRaise | inputsCausingIrqFall );
+
+            /* count edges per input */
+            edgeCount( llHdl->edgeCntRaise[i], inputsCausingIrqRaise );
+            edgeCount( llHdl->edgeCntFall[i], inputsCausingIrqFall );
+            edges += bitCount( inputsCausingIrqRaise ) +
+                bitCount( inputsCausingIrqFall );
+
+            /* frequency measurement on raising edges */
+            if( inputsCausingIrqRaise & llHdl->freqMask[i] )
+                freqEdge( llHdl, i,
+                          inputsCausingIrqRaise & llHdl->freqMask[i], now );
+
+            /* queue event record */
+            if( llHdl->evtDepth ) {
+                input = MREAD_D32( ma, REG_INPUT(llHdl)+i*4 );
+                evtPut( llHdl, i, input, inputsCausingIrqRaise,
+                        inputsCausingIrqFall, now );
+            }
+
+            /* keep edges for next sample */
+            if( llHdl->smpOn && i == llHdl->smpCh ) {
+                llHdl->smpRaise |= inputsCausingIrqRaise;
+                llHdl->smpFall  |= inputsCausingIrqFall;
+            }
+
+            /* wake up waiting caller */
+            if( i == llHdl->waitCh &&
+                ((inputsCausingIrqRaise & llHdl->waitRaiseMask) ||
+                 (inputsCausingIrqFall & llHdl->waitFallMask)) ) {
+                llHdl->waitRaiseMask = llHdl->waitFallMask = 0;
+                OSS_SemSignal( OSH, llHdl->waitSem );
+            }
+        }
+    }
+
+    if( myIrq ) {
+
+        /* if requested send signal to application */
+        if( llHdl->portChangeSig )
+            notify( llHdl, now, edges );
+
+        llHdl->irqCount++;
+        llHdl->stats.irqOwn++;
+
+        /* interrupt timing */
+        if( llHdl->histOn ) {
+            if( llHdl->histIrqSeen )
+                histAdd( &llHdl->histGap, now - llHdl->histLastIrq );
+
+            llHdl->histLastIrq = now;
+            llHdl->histIrqSeen = TRUE;
+            histAdd( &llHdl->histIsr, Z50_TIMESTAMP() - now );
+        }
+
+        return( LL_IRQ_DEVICE );
+    }
+
+    llHdl->stats.irqNotOwn++;
+    return( LL_IRQ_DEV_NOT );
+}
+
+/****************************** Z50_Info ***********************************/
+/** Get information about hardware and driver requirements
+ *
+ *  The following info codes are supported:
+ *
+ * \code
+ *  Code                      Description
+ *  ------------------------  -----------------------------
+ *  LL_INFO_HW_CHARACTER      hardware characteristics
+ *  LL_INFO_ADDRSPACE_COUNT   nr of required address spaces
+ *  LL_INFO_ADDRSPACE         address space information
+ *  LL_INFO_IRQ               interrupt required
+ *  LL_INFO_LOCKMODE          process lock mode required
+ * \endcode
+ *
+ *  The LL_INFO_HW_CHARACTER code returns all address and
+ *  data modes (ORed) which are supported by the hardware
+ *  (MDIS_MAxx, MDIS_MDxx).
+ *
+ *  The LL_INFO_ADDRSPACE_COUNT code returns the number
+ *  of address spaces used by the driver.
+ *
+ *  The LL_INFO_ADDRSPACE code returns information about one
+ *  specific address space (MDIS_MAxx, MDIS_MDxx). The returned
+ *  data mode represents the widest hardware access used by
+ *  the driver.
+ *
+ *  The LL_INFO_IRQ code returns whether the driver supports an
+ *  interrupt routine (TRUE or FALSE).
+ *
+ *  The LL_INFO_LOCKMODE code returns which process locking
+ *  mode the driver needs (LL_LOCK_xxx).
+ *
+ *  \param infoType    \IN  info code
+ *  \param ...         \IN  argument(s)
+ *
+ *  \return            \c 0 on success or error code
+ */
+static int32 Z50_Info(
+   int32  infoType,
+   ...
+)
+{
+    int32   error = ERR_SUCCESS;
+    va_list argptr;
+
+    va_start(argptr, infoType );
+
+    switch(infoType) {
+        /*-------------------------------+
+        |  hardware characteristics      |
+        |  (all addr/data modes ORed)   |
+        +-------------------------------*/
+        case LL_INFO_HW_CHARACTER:
+        {
+            u_int32 *addrModeP = va_arg(argptr, u_int32*);
+            u_int32 *dataModeP = va_arg(argptr, u_int32*);
+
+            *addrModeP = MDIS_MA08;
+            *dataModeP = MDIS_MD08 | MDIS_MD16;
+            break;
+        }
+        /*-------------------------------+
+        |  nr of required address spaces |
+        |  (total spaces used)           |
+        +-------------------------------*/
+        case LL_INFO_ADDRSPACE_COUNT:
+        {
+            u_int32 *nbrOfAddrSpaceP = va_arg(argptr, u_int32*);
+
+            *nbrOfAddrSpaceP = ADDRSPACE_COUNT;
+            break;
+        }
+        /*-------------------------------+
+        |  address space type            |
+        |  (widest used data mode)       |
+        +-------------------------------*/
+        case LL_INFO_ADDRSPACE:
+        {
+            u_int32 addrSpaceIndex = va_arg(argptr, u_int32);
+            u_int32 *addrModeP = va_arg(argptr, u_int32*);
+            u_int32 *dataModeP = va_arg(argptr, u_int32*);
+            u_int32 *addrSizeP = va_arg(argptr, u_int32*);
+
+            if (addrSpaceIndex >= ADDRSPACE_COUNT)
+                error = ERR_LL_ILL_PARAM;
+            else {
+                *addrModeP = MDIS_MA24;
+                *dataModeP = MDIS_MD32;
+                *addrSizeP = ADDRSPACE_SIZE;
+            }
+
+            break;
+        }
+        /*-------------------------------+
+        |   interrupt required           |
+        +-------------------------------*/
+        case LL_INFO_IRQ:
+        {
+            u_int32 *useIrqP = va_arg(argptr, u_int32*);
+
+            *useIrqP = USE_IRQ;
+            break;
+        }
+        /*-------------------------------+
+        |   process lock mode            |
+        +-------------------------------*/
+        case LL_INFO_LOCKMODE:
+        {
+            u_int32 *lockModeP = va_arg(argptr, u_int32*);
+
+            *lockModeP = LL_LOCK_CALL;
+            break;
+        }
+        /*-------------------------------+
+        |   (unknown)                    |
+        +-------------------------------*/
+        default:
+          error = ERR_LL_ILL_PARAM;
+    }
+
+    va_end(argptr);
+    return(error);
+}
+
+/*******************************  Ident  ***********************************/
+/** Return ident string
+ *
+ *  \return            pointer to ident string
+ */
+static char* Ident( void )
+{
+    return( (char*) IdentString );
+}
+
+/********************************* Cleanup *********************************/
+/** Close all handles, free memory and return error code
+ *
+ *  \warning The low-level handle is invalid after this function is called.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param retCode    \IN  return value
+ *
+ *  \return           \IN   retCode
+ */
+static int32 Cleanup(
+   LL_HANDLE    *llHdl,
+   int32        retCode
+)
+{
+    /*------------------------------+
+    |  close handles                |
+    +------------------------------*/
+    /* clean up desc */
+    if (llHdl->descHdl)
+        DESC_Exit(&llHdl->descHdl);
+
+    /* remove semaphores */
+    if (llHdl->waitSem)
+        OSS_SemRemove(llHdl->osHdl, &llHdl->waitSem);
+
+    if (llHdl->waveSem)
+        OSS_SemRemove(llHdl->osHdl, &llHdl->waveSem);
+
+    /* remove alarm, signal and lock */
+    if (llHdl->alarmHdl)
+        OSS_AlarmRemove(llHdl->osHdl, &llHdl->alarmHdl);
+
+    if (llHdl->waveSig)
+        OSS_SigRemove(llHdl->osHdl, &llHdl->waveSig);
+
+    if (llHdl->outLock)
+        OSS_SpinLockRemove(llHdl->osHdl, &llHdl->outLock);
+
+    /* free waveform */
+    if (llHdl->waveBuf)
+        OSS_MemFree(llHdl->osHdl, (int8*)llHdl->waveBuf, llHdl->waveMemSize);
+
+    /* free sample ring */
+    if (llHdl->smpBuf)
+        OSS_MemFree(llHdl->osHdl, (int8*)llHdl->smpBuf, llHdl->smpMemSize);
+
+    /* free event ring */
+    if (llHdl->evtBuf)
+        OSS_MemFree(llHdl->osHdl, (int8*)llHdl->evtBuf, llHdl->evtMemSize);
+
+    /* clean up debug */
+    DBGEXIT((&DBH));
+
+    /*------------------------------+
+    |  free memory                  |
+    +------------------------------*/
+    /* free my handle */
+    OSS_MemFree(llHdl->osHdl, (int8*)llHdl, llHdl->memAlloc);
+
+    /*------------------------------+
+    |  return error code            |
+    +------------------------------*/
+    return(retCode);
+}
+
+/**********************************************************************/
+/** Reset GPIO controller
+ *
+ *  Sets the controller registers to default values:
+ *  - all interrupt disabled
+ *  - all outputs off
+ *  - debouncing disabled
+ *  - D302i with Z50_D302I_GIP: global interrupt disabled (GIEN), it is
+ *    set again by M_MK_IRQ_ENABLE. Without Z50_D302I_GIP the control
+ *    register is not accessed, it is outside the announced address space.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+
+static void
+gpioReset( LL_HANDLE *llHdl )
+{
+    MACCESS ma = llHdl->ma;
+    int i, numRegs;
+
+    /* reset internal control logic (BIOC only) */
+    if( ! IS_D302I(llHdl) ) {
+        MWRITE_D32( ma, REG_CONTROL(llHdl), 1 );
+    }
+    else if( USE_GIP(llHdl) ) {
+        MCLRMASK_D32( ma, D302I_CTRL, D302I_CTRL_GIEN );
+    }
+
+    numRegs = NUM_REGS(llHdl);
+
+    /* for all registers */
+    for( i=0; i<numRegs; ++i ) {
+
+        /* disable all interrupts */
+        llHdl->reqIrqRaise[i] = llHdl->reqIrqFall[i] = 0;
+        llHdl->shIrqRaise[i] = llHdl->shIrqFall[i] = 0;
+        llHdl->quarMask[i] = 0;
+        MWRITE_D32( ma, REG_IRQ_EDGE_RAISE(llHdl)+i*4, 0 );
+        MWRITE_D32( ma, REG_IRQ_EDGE_FALL(llHdl)+i*4, 0 );
+
+        /* switch off all outputs */
+        llHdl->shOutput[i] = 0;
+        MWRITE_D32( ma, REG_OUTPUT(llHdl)+i*4, 0 );
+
+        /* reset edge registers */
+        MWRITE_D32( ma, REG_EDGE_RAISE(llHdl)+i*4, 0xffffffff );
+        MWRITE_D32( ma, REG_EDGE_FALL(llHdl)+i*4,  0xffffffff );
+    }
+    llHdl->irqChMask = 0;
+
+    /* disable debouncer */
+    numRegs = NUM_DEBOUNCE(llHdl);
+
+    for( i=0; i<numRegs; ++i ) {
+        llHdl->shDebounce[i] = 0;
+        MWRITE_D32( ma, REG_DEBOUNCE(llHdl)+i*4, 0 );
+    }
+}
+
+/**********************************************************************/
+/** Compare shadow registers with hardware
+ *
+ *  \param llHdl      \IN  low-level handle
+ *
+ *  \return           Z50_SHADOW_xxx flags of mismatching registers
+ *                    (0 if all shadows are valid)
+ */
+static u_int32
+shadowCheck( LL_HANDLE *llHdl )
+{
+    MACCESS ma = llHdl->ma;
+    int i, numRegs;
+    u_int32 flags = 0;
+
+    numRegs = NUM_REGS(llHdl);
+
+    for( i=0; i<numRegs; ++i ) {
+        if( MREAD_D32( ma, REG_IRQ_EDGE_RAISE(llHdl)+i*4 ) !=
+            llHdl->shIrqRaise[i] )
+            flags |= Z50_SHADOW_IRQ_RAISE;
+
+        if( MREAD_D32( ma, REG_IRQ_EDGE_FALL(llHdl)+i*4 ) !=
+            llHdl->shIrqFall[i] )
+            flags |= Z50_SHADOW_IRQ_FALL;
+
+        if( MREAD_D32( ma, REG_OUTPUT(llHdl)+i*4 ) != llHdl->shOutput[i] )
+            flags |= Z50_SHADOW_OUTPUT;
+    }
+
+    numRegs = NUM_DEBOUNCE(llHdl);
+
+    for( i=0; i<numRegs; ++i ) {
+        if( MREAD_D32( ma, REG_DEBOUNCE(llHdl)+i*4 ) !=
+            llHdl->shDebounce[i] )
+            flags |= Z50_SHADOW_DEBOUNCE;
+    }
+
+    DBGWRT_2((DBH, " shadowCheck: flags=0x%x\n", flags));
+
+    return( flags );
+}
+
+/**********************************************************************/
+/** Queue edge event record (called from interrupt)
+ *
+ *  If the ring is full, the event is dropped and counted as lost. Its
+ *  sequence number is consumed anyway, so the gap is visible to the
+ *  application.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel
+ *  \param input      \IN  state of inputs
+ *  \param raise      \IN  inputs with raising edge
+ *  \param fall       \IN  inputs with falling edge
+ *  \param time       \IN  timestamp of interrupt
+ */
+static void
+evtPut( LL_HANDLE *llHdl, u_int32 ch, u_int32 input, u_int32 raise,
+        u_int32 fall, u_int32 time )
+{
+    Z50_EVENT *evt;
+
+    if( llHdl->evtCount == llHdl->evtDepth ) {
+        llHdl->evtSeq++;
+        llHdl->evtLost++;
+        llHdl->evtLostTotal++;
+        return;
+    }
+
+    evt = (Z50_EVENT*)llHdl->evtBuf + llHdl->evtIn;
+
+    evt->seq   = llHdl->evtSeq++;
+    evt->time  = time;
+    evt->ch    = ch;
+    evt->raise = raise;
+    evt->fall  = fall;
+    evt->input = input;
+
+    if( ++llHdl->evtIn == llHdl->evtDepth )
+        llHdl->evtIn = 0;
+
+    llHdl->evtCount++;
+}
+
+/**********************************************************************/
+/** Wait for edge on inputs of one channel
+ *
+ *  Returns immediately if one of the requested edges was already
+ *  recorded by the interrupt routine. Otherwise the masks are handed to
+ *  the interrupt routine, which signals the wait semaphore as soon as a
+ *  matching edge occurs. The device semaphore is released while waiting,
+ *  so other calls to the device are not blocked.
+ *
+ *  The returned edges are removed from the bits collected for
+ *  Z50_EDGE_RAISE/Z50_EDGE_FALL. Edges of inputs without interrupt are
+ *  only seen if the channel is sampled (Z50_SAMPLING), sampleTick() then
+ *  wakes the caller with a delay of up to one sample period.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel
+ *  \param pb         \IN  masks and timeout
+ *                    \OUT matching edges
+ *
+ *  \return           \c 0 on success, ERR_OSS_TIMEOUT or error code
+ */
+static int32
+waitEdge( LL_HANDLE *llHdl, int32 ch, Z50_WAIT_PB *pb )
+{
+    OSS_IRQ_STATE irqState;
+    u_int32 startTick, elapsed, rate;
+    int32 remain = pb->timeout;
+    int32 error = ERR_SUCCESS;
+
+    pb->raise = pb->fall = 0;
+
+    /* only one waiter supported */
+    if( llHdl->waitActive )
+        return( ERR_LL_DEV_BUSY );
+
+    llHdl->waitActive = TRUE;
+    startTick = OSS_TickGet( OSH );
+
+    for(;;) {
+        irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+        /* edges already recorded ? */
+        pb->raise = llHdl->edgeRaiseIrq[ch] & pb->raiseMask;
+        pb->fall  = llHdl->edgeFallIrq[ch] & pb->fallMask;
+
+        if( pb->raise || pb->fall ) {
+            llHdl->edgeRaiseIrq[ch] &= ~pb->raise;
+            llHdl->edgeFallIrq[ch]  &= ~pb->fall;
+            llHdl->waitRaiseMask = llHdl->waitFallMask = 0;
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            error = ERR_SUCCESS;
+            break;
+        }
+
+        /* compute remaining time */
+        if( pb->timeout > 0 ) {
+            /* divide first, ticks*1000 would overflow after some time */
+            elapsed = OSS_TickGet( OSH ) - startTick;
+            rate    = OSS_TickRateGet( OSH );
+            elapsed = elapsed / rate * 1000 + elapsed % rate * 1000 / rate;
+            remain = (elapsed < (u_int32)pb->timeout) ?
+                pb->timeout - (int32)elapsed : 0;
+        }
+
+        if( remain == 0 ) {
+            llHdl->waitRaiseMask = llHdl->waitFallMask = 0;
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            error = ERR_OSS_TIMEOUT;
+            break;
+        }
+
+        /* arm interrupt routine */
+        llHdl->waitCh        = ch;
+        llHdl->waitRaiseMask = pb->raiseMask;
+        llHdl->waitFallMask  = pb->fallMask;
+        OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+
+        /* release device semaphore while waiting */
+        OSS_SemSignal( OSH, llHdl->devSemHdl );
+        error = OSS_SemWait( OSH, llHdl->waitSem,
+                             remain < 0 ? OSS_SEM_WAITFOREVER : remain );
+        OSS_SemWait( OSH, llHdl->devSemHdl, OSS_SEM_WAITFOREVER );
+
+        /* on timeout check once more for edges */
+        if( error == ERR_OSS_TIMEOUT )
+            remain = 0;
+        else if( error ) {
+            irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+            llHdl->waitRaiseMask = llHdl->waitFallMask = 0;
+            OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+            break;
+        }
+    }
+
+    llHdl->waitActive = FALSE;
+
+    DBGWRT_2((DBH, " waitEdge: ch=%d raise=0x%08x fall=0x%08x err=0x%x\n",
+              ch, pb->raise, pb->fall, error));
+
+    return( error );
+}
+
+/**********************************************************************/
+/** Get and clear edges of one channel (called with interrupts masked)
+ *
+ *  Combines the edges collected by the interrupt routine (and input
+ *  sampling) with the edge register bits of inputs without interrupt,
+ *  then acknowledges these register bits.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel
+ *  \param raiseP     \OUT raising edges (NULL=leave pending)
+ *  \param fallP      \OUT falling edges (NULL=leave pending)
+ */
+static void
+edgeGet( LL_HANDLE *llHdl, int32 ch, u_int32 *raiseP, u_int32 *fallP )
+{
+    MACCESS ma = llHdl->ma;
+    u_int32 bitsNotFromIrq;
+
+    if( raiseP ) {
+        bitsNotFromIrq = MREAD_D32( ma, REG_EDGE_RAISE(llHdl)+ch*4 ) &
+            ~llHdl->shIrqRaise[ch];
+
+        *raiseP = llHdl->edgeRaiseIrq[ch] | bitsNotFromIrq;
+
+        if( bitsNotFromIrq )
+            MWRITE_D32( ma, REG_EDGE_RAISE(llHdl)+ch*4, bitsNotFromIrq );
+        llHdl->edgeRaiseIrq[ch] = 0;
+    }
+
+    if( fallP ) {
+        bitsNotFromIrq = MREAD_D32( ma, REG_EDGE_FALL(llHdl)+ch*4 ) &
+            ~llHdl->shIrqFall[ch];
+
+        *fallP = llHdl->edgeFallIrq[ch] | bitsNotFromIrq;
+
+        if( bitsNotFromIrq )
+            MWRITE_D32( ma, REG_EDGE_FALL(llHdl)+ch*4, bitsNotFromIrq );
+        llHdl->edgeFallIrq[ch] = 0;
+    }
+}
+
+/**********************************************************************/
+/** Update bitmap of channels with enabled interrupts
+ *
+ *  The interrupt routine only looks at channels whose bit is set.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel whose irq masks were changed
+ */
+static void
+irqChMaskUpdate( LL_HANDLE *llHdl, int32 ch )
+{
+    OSS_IRQ_STATE irqState;
+
+    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+    /* user masks: quarantined inputs are re-armed without update */
+    if( llHdl->reqIrqRaise[ch] | llHdl->reqIrqFall[ch] )
+        llHdl->irqChMask |= (1<<ch);
+    else
+        llHdl->irqChMask &= ~(1<<ch);
+
+    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+}
+
+/**********************************************************************/
+/** Increment edge counters of all inputs set in mask
+ *
+ *  \param cnt        \IN  counter array of one channel (IN_NUMBER entries)
+ *  \param mask       \IN  inputs with edge
+ */
+static void
+edgeCount( u_int64 *cnt, u_int32 mask )
+{
+    for( ; mask; mask >>= 1, ++cnt ) {
+        if( mask & 1 )
+            (*cnt)++;
+    }
+}
+
+/**********************************************************************/
+/** Frequency measurement: process raising edges (called from interrupt)
+ *
+ *  Measures the period since the last raising edge of every input in
+ *  mask. The gates are aligned to edges: a gate is closed by the first
+ *  edge that occurs after the gate time has elapsed, which then also
+ *  starts the next gate.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel
+ *  \param mask       \IN  inputs with raising edge to measure
+ *  \param now        \IN  timestamp of interrupt
+ */
+static void
+freqEdge( LL_HANDLE *llHdl, u_int32 ch, u_int32 mask, u_int32 now )
+{
+    FREQ_IN *f = llHdl->freq[ch];
+    u_int32 period;
+
+    for( ; mask; mask >>= 1, ++f ) {
+        if( !(mask & 1) )
+            continue;
+
+        /* first edge: start gate */
+        if( !f->valid ) {
+            f->valid       = TRUE;
+            f->lastTime    = now;
+            f->gateStart   = now;
+            f->gatePeriods = 0;
+            continue;
+        }
+
+        period = now - f->lastTime;
+        f->lastTime = now;
+        f->period   = period;
+
+        if( f->minPeriod == 0 || period < f->minPeriod )
+            f->minPeriod = period;
+        if( period > f->maxPeriod )
+            f->maxPeriod = period;
+
+        f->gatePeriods++;
+
+        /* gate elapsed ? */
+        if( now - f->gateStart >= llHdl->freqGateTicks ) {
+            f->resPeriods  = f->gatePeriods;
+            f->resTime     = now - f->gateStart;
+            f->gateStart   = now;
+            f->gatePeriods = 0;
+        }
+    }
+}
+
+/**********************************************************************/
+/** Convert milliseconds to timestamp ticks (at least 1)
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param msec       \IN  time [ms]
+ *
+ *  \return           time [ticks]
+ */
+static u_int32
+msToTicks( LL_HANDLE *llHdl, u_int32 msec )
+{
+    u_int32 ticks = mulDiv( msec, Z50_TIMESTAMP_RATE(), 1000 );
+
+    (void)llHdl;
+
+    return( ticks ? ticks : 1 );
+}
+
+/**********************************************************************/
+/** Compute a * b / c without 64 bit division
+ *
+ *  The product is kept in 64 bit, the division is done bit by bit, so
+ *  no 64 bit division from the compiler library is needed (not available
+ *  in all kernels).
+ *
+ *  \param a          \IN  factor
+ *  \param b          \IN  factor
+ *  \param c          \IN  divisor (non-zero)
+ *
+ *  \return           a * b / c, 0xffffffff if the result exceeds 32 bit
+ */
+static u_int32
+mulDiv( u_int32 a, u_int32 b, u_int32 c )
+{
+    u_int64 prod = (u_int64)a * b;
+    u_int64 rem;
+    u_int32 quot = 0, low = (u_int32)prod;
+    int i;
+
+    if( (prod >> 32) == 0 )
+        return( low / c );
+
+    /* quotient would not fit into 32 bit */
+    rem = prod >> 32;
+    if( rem >= c )
+        return( 0xffffffff );
+
+    for( i=31; i>=0; i-- ) {
+        rem = (rem << 1) | ((low >> i) & 1);
+        quot <<= 1;
+        if( rem >= c ) {
+            rem -= c;
+            quot |= 1;
+        }
+    }
+    return( quot );
+}
+
+/**********************************************************************/
+/** Update outputs of one channel
+ *
+ *  Uses the shadow register, so the output register is written only
+ *  once. The caller must hold the output lock.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel
+ *  \param mask       \IN  outputs to change
+ *  \param value      \IN  new state of the outputs in mask
+ */
+static void
+outputSet( LL_HANDLE *llHdl, int32 ch, u_int32 mask, u_int32 value )
+{
+    llHdl->shOutput[ch] = (llHdl->shOutput[ch] & ~mask) | (value & mask);
+    MWRITE_D32( llHdl->ma, REG_OUTPUT(llHdl)+ch*4, llHdl->shOutput[ch] );
+}
 
-    /* return number of read bytes */
-    *nbrRdBytesP = 0;
+/**********************************************************************/
+/** Driver timer handler (called by OSS alarm)
+ *
+ *  Runs all timed functions with the output lock held.
+ *
+ *  \param arg        \IN  low-level handle
+ */
+static void
+alarmHandler( void *arg )
+{
+    LL_HANDLE *llHdl = (LL_HANDLE*)arg;
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+
+    if( llHdl->timerUsers & TMR_WAVE )
+        waveTick( llHdl );
+
+    if( llHdl->timerUsers & TMR_PWM )
+        pwmTick( llHdl );
+
+    if( llHdl->timerUsers & TMR_SAMPLE )
+        sampleTick( llHdl );
 
-    return( ERR_LL_ILL_FUNC );
+    if( llHdl->timerUsers & TMR_NOTIFY )
+        notifyTick( llHdl );
+
+    if( llHdl->timerUsers & TMR_QUAR )
+        quarTick( llHdl );
+
+    /* all timed functions finished */
+    if( llHdl->timerUsers == 0 && llHdl->timerRunning ) {
+        OSS_AlarmClear( OSH, llHdl->alarmHdl );
+        llHdl->timerRunning = FALSE;
+    }
+
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
 }
 
-/****************************** Z50_BlockWrite *****************************/
-/** Write a data block from the device
+/**********************************************************************/
+/** Start driver timer for a timed function
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param user       \IN  timed function (TMR_xxx)
+ *
+ *  \return           \c 0 on success or error code
+ */
+static int32
+timerStart( LL_HANDLE *llHdl, u_int32 user )
+{
+    u_int32 realMsec, start;
+    int32 error;
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+    llHdl->timerUsers |= user;
+    start = !llHdl->timerRunning;
+    llHdl->timerRunning = TRUE;
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+    if( start ) {
+        if( (error = OSS_AlarmSet( OSH, llHdl->alarmHdl, llHdl->timerPeriod,
+                                   TRUE, &realMsec )) ) {
+            OSS_SpinLockAcquire( OSH, llHdl->outLock );
+            llHdl->timerUsers &= ~user;
+            llHdl->timerRunning = FALSE;
+            OSS_SpinLockRelease( OSH, llHdl->outLock );
+            return( error );
+        }
+
+        if( realMsec != llHdl->timerPeriod ) {
+            DBGWRT_ERR((DBH, "*** LL - timerStart: period %d ms instead "
+                        "of %d ms\n", realMsec, llHdl->timerPeriod));
+        }
+
+        DBGWRT_2((DBH, " timer started: %d ms\n", realMsec));
+    }
+
+    return( ERR_SUCCESS );
+}
+
+/**********************************************************************/
+/** Stop timed function, stop driver timer if unused
+ *
+ *  Timed functions that finish by themselves only clear their bit in
+ *  timerUsers, alarmHandler() then stops the alarm after the tick.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param user       \IN  timed functions to stop (TMR_xxx)
+ */
+static void
+timerStop( LL_HANDLE *llHdl, u_int32 user )
+{
+    u_int32 stop;
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+    llHdl->timerUsers &= ~user;
+    stop = llHdl->timerUsers == 0 && llHdl->timerRunning;
+    if( stop )
+        llHdl->timerRunning = FALSE;
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+    if( stop ) {
+        OSS_AlarmClear( OSH, llHdl->alarmHdl );
+        DBGWRT_2((DBH, " timer stopped\n"));
+    }
+}
+
+/**********************************************************************/
+/** Load waveform and start playback
+ *
+ *  Copies the steps into a driver buffer and converts the delays into
+ *  timer ticks (rounded up). The first step is output at the next
+ *  timer tick.
  *
  *  \param llHdl       \IN  low-level handle
- *  \param ch          \IN  current channel
- *  \param buf         \IN  data buffer
+ *  \param ch          \IN  output channel
+ *  \param buf         \IN  Z50_WAVE_STEP records
  *  \param size        \IN  data buffer size
  *  \param nbrWrBytesP \OUT number of written bytes
  *
  *  \return            \c 0 on success or error code
  */
-static int32 Z50_BlockWrite(
-     LL_HANDLE *llHdl,
-     int32     ch,
-     void      *buf,
-     int32     size,
-     int32     *nbrWrBytesP
-)
+static int32
+waveStart( LL_HANDLE *llHdl, int32 ch, void *buf, int32 size,
+           int32 *nbrWrBytesP )
 {
-    DBGWRT_1((DBH, "LL - Z50_BlockWrite: ch=%d, size=%d\n",ch,size));
+    Z50_WAVE_STEP *step;
+    u_int32 n, i, total = 0;
 
-    /* return number of written bytes */
-    *nbrWrBytesP = 0;
+    n = size / sizeof(Z50_WAVE_STEP);
+
+    if( n == 0 || size % sizeof(Z50_WAVE_STEP) )
+        return( ERR_LL_ILL_PARAM );
+
+    if( llHdl->waveState == Z50_WAVE_RUNNING )
+        return( ERR_LL_DEV_BUSY );
+
+    /* timer no longer accesses old waveform */
+    timerStop( llHdl, TMR_WAVE );
+
+    if( llHdl->waveBuf ) {
+        OSS_MemFree( OSH, (int8*)llHdl->waveBuf, llHdl->waveMemSize );
+        llHdl->waveBuf = NULL;
+    }
+
+    if( (llHdl->waveBuf = OSS_MemGet( OSH, n * sizeof(Z50_WAVE_STEP),
+                                      &llHdl->waveMemSize )) == NULL )
+        return( ERR_OSS_MEM_ALLOC );
+
+    OSS_MemCopy( OSH, n * sizeof(Z50_WAVE_STEP), (char*)buf,
+                 (char*)llHdl->waveBuf );
+
+    /* convert delays from usec to ticks */
+    for( i=0, step=(Z50_WAVE_STEP*)llHdl->waveBuf; i<n; ++i, ++step ) {
+        step->delay = usToTicks( llHdl, step->delay );
+        total += step->delay;
+    }
+
+    /* waveform without delay would be output within one tick */
+    if( total == 0 )
+        return( ERR_LL_ILL_PARAM );
+
+    /* discard completion of previous waveform */
+    OSS_SemWait( OSH, llHdl->waveSem, OSS_SEM_NOWAIT );
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+    llHdl->waveSteps     = n;
+    llHdl->waveCh        = ch;
+    llHdl->waveIdx       = 0;
+    llHdl->waveWait      = 1;
+    llHdl->waveLoopsLeft = llHdl->waveLoops;   /* Z50_WAVE_LOOPS may change */
+    llHdl->waveState     = Z50_WAVE_RUNNING;
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+    DBGWRT_2((DBH, " waveStart: ch=%d steps=%d loops=%d\n",
+              ch, n, llHdl->waveLoops));
+
+    *nbrWrBytesP = n * sizeof(Z50_WAVE_STEP);
+
+    return( timerStart( llHdl, TMR_WAVE ) );
+}
+
+/**********************************************************************/
+/** Waveform playback: timer tick (called with output lock held)
+ *
+ *  Outputs the next step(s) when the delay of the previous step has
+ *  elapsed. Steps without delay are output within the same tick.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void
+waveTick( LL_HANDLE *llHdl )
+{
+    Z50_WAVE_STEP *step;
+
+    /* stopped ? */
+    if( llHdl->waveState != Z50_WAVE_RUNNING ) {
+        llHdl->timerUsers &= ~TMR_WAVE;
+        return;
+    }
+
+    /* delay of previous step elapsed ? */
+    if( --llHdl->waveWait )
+        return;
+
+    for(;;) {
+        /* end of sequence: repeat or finish */
+        if( llHdl->waveIdx == llHdl->waveSteps ) {
+            if( llHdl->waveLoopsLeft == 0 || --llHdl->waveLoopsLeft ) {
+                llHdl->waveIdx = 0;
+            }
+            else {
+                llHdl->waveState = Z50_WAVE_IDLE;
+                llHdl->timerUsers &= ~TMR_WAVE;
+
+                OSS_SemSignal( OSH, llHdl->waveSem );
+                if( llHdl->waveSig ) {
+                    OSS_IRQ_STATE irqState;
+
+                    /* signal counters are shared with Z50_Irq */
+                    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+                    sigSend( llHdl, llHdl->waveSig );
+                    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+                }
+                return;
+            }
+        }
+
+        step = (Z50_WAVE_STEP*)llHdl->waveBuf + llHdl->waveIdx++;
+        outputSet( llHdl, llHdl->waveCh, step->mask, step->value );
+
+        if( step->delay ) {
+            llHdl->waveWait = step->delay;
+            return;
+        }
+    }
+}
+
+/**********************************************************************/
+/** Wait for end of waveform playback
+ *
+ *  The device semaphore is released while waiting.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param pb         \IN  timeout
+ *                    \OUT playback state
+ *
+ *  \return           \c 0 if playback finished, ERR_OSS_TIMEOUT or
+ *                    error code
+ */
+static int32
+waveWaitEnd( LL_HANDLE *llHdl, Z50_WAVE_WAIT_PB *pb )
+{
+    int32 error = ERR_SUCCESS;
+
+    if( llHdl->waveState == Z50_WAVE_RUNNING ) {
+        if( pb->timeout == 0 ) {
+            error = ERR_OSS_TIMEOUT;
+        }
+        else {
+            OSS_SemSignal( OSH, llHdl->devSemHdl );
+            error = OSS_SemWait( OSH, llHdl->waveSem,
+                                 pb->timeout < 0 ? OSS_SEM_WAITFOREVER :
+                                 pb->timeout );
+            OSS_SemWait( OSH, llHdl->devSemHdl, OSS_SEM_WAITFOREVER );
+        }
+    }
+
+    pb->state = llHdl->waveState;
+
+    return( error );
+}
+
+/**********************************************************************/
+/** Software PWM: configure outputs
+ *
+ *  Period and high time are rounded up to timer ticks. The outputs in
+ *  pb->mask restart their period at the next tick, so outputs configured
+ *  together run in phase.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  output channel
+ *  \param pb         \IN  outputs, period and high time
+ *
+ *  \return           \c 0 on success or error code
+ */
+static int32
+pwmSet( LL_HANDLE *llHdl, int32 ch, Z50_PWM_PB *pb )
+{
+    u_int32 period, duty, any = 0;
+    int i;
+
+    if( pb->duty > pb->period )
+        return( ERR_LL_ILL_PARAM );
+
+    period = usToTicks( llHdl, pb->period );
+    duty   = usToTicks( llHdl, pb->duty );
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+
+    for( i=0; i<IN_NUMBER; ++i ) {
+        if( pb->mask & ((u_int32)1 << i) ) {
+            llHdl->pwmPeriod[ch][i] = period;
+            llHdl->pwmDuty[ch][i]   = duty;
+            llHdl->pwmCnt[ch][i]    = 0;
+        }
+    }
+
+    if( period )
+        llHdl->pwmMask[ch] |= pb->mask;
+    else
+        llHdl->pwmMask[ch] &= ~pb->mask;
+
+    for( i=0; i<CH_NUMBER; ++i )
+        any |= llHdl->pwmMask[i];
+
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+    DBGWRT_2((DBH, " pwmSet: ch=%d mask=0x%08x period=%d duty=%d ticks\n",
+              ch, pb->mask, period, duty));
+
+    if( !any ) {
+        timerStop( llHdl, TMR_PWM );
+        return( ERR_SUCCESS );
+    }
+
+    return( timerStart( llHdl, TMR_PWM ) );
+}
+
+/**********************************************************************/
+/** Software PWM: timer tick (called with output lock held)
+ *
+ *  Computes the new state of all PWM outputs of a channel and updates
+ *  the output register with a single write, only if it changed.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void
+pwmTick( LL_HANDLE *llHdl )
+{
+    u_int32 ch, mask, value;
+    int i;
+
+    for( ch=0; ch<CH_NUMBER; ++ch ) {
+        if( (mask = llHdl->pwmMask[ch]) == 0 )
+            continue;
+
+        value = 0;
+        for( i=0; i<IN_NUMBER; ++i ) {
+            if( !(mask & ((u_int32)1 << i)) )
+                continue;
+
+            if( llHdl->pwmCnt[ch][i] < llHdl->pwmDuty[ch][i] )
+                value |= (u_int32)1 << i;
+
+            if( ++llHdl->pwmCnt[ch][i] >= llHdl->pwmPeriod[ch][i] )
+                llHdl->pwmCnt[ch][i] = 0;
+        }
+
+        if( (llHdl->shOutput[ch] ^ value) & mask )
+            outputSet( llHdl, ch, mask, value );
+    }
+}
+
+/**********************************************************************/
+/** Convert microseconds to timer ticks (rounded up)
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param usec       \IN  time [us]
+ *
+ *  \return           number of timer ticks
+ */
+static u_int32
+usToTicks( LL_HANDLE *llHdl, u_int32 usec )
+{
+    u_int32 usPerTick = llHdl->timerPeriod * 1000;
+
+    return( usec / usPerTick + (usec % usPerTick ? 1 : 0) );
+}
+
+/**********************************************************************/
+/** Input sampling: start sampling a channel
+ *
+ *  Discards all queued samples and restarts the sequence numbers.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel to sample
+ *
+ *  \return           \c 0 on success or error code
+ */
+static int32
+sampleStart( LL_HANDLE *llHdl, int32 ch )
+{
+    OSS_IRQ_STATE irqState;
+
+    if( llHdl->smpDepth == 0 )
+        return( ERR_LL_ILL_FUNC );
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+    llHdl->smpIn    = 0;
+    llHdl->smpCount = 0;
+    llHdl->smpSeq   = 0;
+    llHdl->smpLost  = 0;
+    llHdl->smpWait  = 1;
+    llHdl->smpCh    = ch;
+
+    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+    llHdl->smpRaise = llHdl->smpFall = 0;
+    llHdl->smpOn    = TRUE;
+    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+    DBGWRT_2((DBH, " sampleStart: ch=%d period=%d ticks\n",
+              ch, llHdl->smpPeriod));
+
+    return( timerStart( llHdl, TMR_SAMPLE ) );
+}
+
+/**********************************************************************/
+/** Input sampling: stop sampling
+ *
+ *  Queued samples can still be read.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void
+sampleStop( LL_HANDLE *llHdl )
+{
+    OSS_IRQ_STATE irqState;
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+    llHdl->smpOn = FALSE;
+    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+    timerStop( llHdl, TMR_SAMPLE );
+}
+
+/**********************************************************************/
+/** Input sampling: timer tick (called with output lock held)
+ *
+ *  Reads the inputs and the edge registers of the sampled channel, so
+ *  pulses shorter than the sample period are not missed. Edges of inputs
+ *  with interrupt enabled are collected by the interrupt routine. Other
+ *  edges are cleared here and kept for GetStats Z50_EDGE_RAISE/FALL;
+ *  a caller waiting in Z50_BLK_WAIT_EDGE for them is woken up.
+ *
+ *  In format Z50_SMP_RLE a record is only stored for the first sample,
+ *  when the input state changed or when edges occurred, so the record
+ *  stands for all following samples up to the next record.
+ *
+ *  If the ring is full, the sample is dropped and counted as lost. Its
+ *  sequence number is consumed anyway.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void
+sampleTick( LL_HANDLE *llHdl )
+{
+    MACCESS ma = llHdl->ma;
+    OSS_IRQ_STATE irqState;
+    Z50_SAMPLE *smp;
+    u_int32 ch = llHdl->smpCh, input, raise, fall;
+
+    if( --llHdl->smpWait )
+        return;
+
+    llHdl->smpWait = llHdl->smpPeriod;
+
+    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
+
+    input = MREAD_D32( ma, REG_INPUT(llHdl)+ch*4 );
+
+    raise = MREAD_D32( ma, REG_EDGE_RAISE(llHdl)+ch*4 ) &
+        ~llHdl->shIrqRaise[ch];
+    fall  = MREAD_D32( ma, REG_EDGE_FALL(llHdl)+ch*4 ) &
+        ~llHdl->shIrqFall[ch];
+
+    if( raise ) {
+        MWRITE_D32( ma, REG_EDGE_RAISE(llHdl)+ch*4, raise );
+        llHdl->edgeRaiseIrq[ch] |= raise;
+    }
+    if( fall ) {
+        MWRITE_D32( ma, REG_EDGE_FALL(llHdl)+ch*4, fall );
+        llHdl->edgeFallIrq[ch] |= fall;
+    }
+
+    /* wake up waiting caller, as Z50_Irq does for inputs with irq */
+    if( ch == llHdl->waitCh &&
+        ((raise & llHdl->waitRaiseMask) || (fall & llHdl->waitFallMask)) ) {
+        llHdl->waitRaiseMask = llHdl->waitFallMask = 0;
+        OSS_SemSignal( OSH, llHdl->waitSem );
+    }
+
+    raise |= llHdl->smpRaise;
+    fall  |= llHdl->smpFall;
+    llHdl->smpRaise = llHdl->smpFall = 0;
+
+    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
 
-    return( ERR_LL_ILL_FUNC );
+    /* run-length: unchanged sample extends previous record */
+    if( llHdl->smpFormat == Z50_SMP_RLE && llHdl->smpSeq != 0 &&
+        input == llHdl->smpLast && !raise && !fall ) {
+        llHdl->smpSeq++;
+        return;
+    }
+
+    /* ring full: sample is lost, smpLast stays the last stored input */
+    if( llHdl->smpCount == llHdl->smpDepth ) {
+        llHdl->smpSeq++;
+        llHdl->smpLost++;
+        return;
+    }
+
+    llHdl->smpLast = input;
+
+    smp = (Z50_SAMPLE*)llHdl->smpBuf + llHdl->smpIn;
+
+    smp->seq   = llHdl->smpSeq++;
+    smp->input = input;
+    smp->raise = raise;
+    smp->fall  = fall;
+
+    if( ++llHdl->smpIn == llHdl->smpDepth )
+        llHdl->smpIn = 0;
+
+    llHdl->smpCount++;
 }
 
+/**********************************************************************/
+/** Input sampling: read queued samples
+ *
+ *  \param llHdl       \IN  low-level handle
+ *  \param buf         \IN  data buffer
+ *  \param size        \IN  data buffer size
+ *  \param nbrRdBytesP \OUT number of read bytes
+ *
+ *  \return            \c 0 on success or error code
+ */
+static int32
+sampleRead( LL_HANDLE *llHdl, void *buf, int32 size, int32 *nbrRdBytesP )
+{
+    Z50_SAMPLE_HDR *hdr = (Z50_SAMPLE_HDR*)buf;
+    Z50_SAMPLE *smp = (Z50_SAMPLE*)(hdr+1);
+    u_int32 n, out;
+
+    if( llHdl->smpDepth == 0 )
+        return( ERR_LL_ILL_FUNC );
+
+    if( size < (int32)sizeof(Z50_SAMPLE_HDR) )
+        return( ERR_LL_USERBUF );
+
+    /* number of records fitting into user buffer */
+    n = (size - sizeof(Z50_SAMPLE_HDR)) / sizeof(Z50_SAMPLE);
+
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+
+    if( n > llHdl->smpCount )
+        n = llHdl->smpCount;
+
+    /* index of oldest record */
+    out = (llHdl->smpIn + llHdl->smpDepth - llHdl->smpCount) %
+        llHdl->smpDepth;
+
+    hdr->count   = n;
+    hdr->pending = llHdl->smpCount - n;
+    hdr->lost    = llHdl->smpLost;
+    hdr->period  = llHdl->smpPeriod * llHdl->timerPeriod;
+    hdr->format  = llHdl->smpFormat;
+    hdr->nextSeq = llHdl->smpSeq;
+
+    llHdl->smpCount -= n;
+    llHdl->smpLost = 0;
+
+    *nbrRdBytesP = sizeof(Z50_SAMPLE_HDR) + n * sizeof(Z50_SAMPLE);
+
+    while( n-- ) {
+        *smp++ = ((Z50_SAMPLE*)llHdl->smpBuf)[out];
+        if( ++out == llHdl->smpDepth )
+            out = 0;
+    }
+
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
+
+    return( ERR_SUCCESS );
+}
 
-/****************************** Z50_Irq ************************************/
-/** Interrupt service routine
- *
- *  The interrupt is triggered when one or more input ports change state.
- *  Depends on current setting via Z16_IRQ_SENSE.
+/**********************************************************************/
+/** Send signal to application, coalesced (called from interrupt)
  *
- *  If the driver can detect the interrupt's cause it returns
- *  LL_IRQ_DEVICE or LL_IRQ_DEV_NOT, otherwise LL_IRQ_UNKNOWN.
+ *  The signal is sent if the holdoff time has elapsed since the last
+ *  signal or if the threshold of pending edges is reached. Otherwise
+ *  the edges stay pending and the signal is sent by notifyTick().
  *
- *  \param llHdl       \IN  low-level handle
- *  \return LL_IRQ_DEVICE   irq caused by device
- *          LL_IRQ_DEV_NOT  irq not caused by device
- *          LL_IRQ_UNKNOWN  unknown
+ *  \param llHdl      \IN  low-level handle
+ *  \param now        \IN  timestamp of interrupt
+ *  \param edges      \IN  number of edges in this interrupt
  */
-static int32 Z50_Irq(
-    LL_HANDLE *llHdl
-)
+static void
+notify( LL_HANDLE *llHdl, u_int32 now, u_int32 edges )
 {
-    MACCESS ma = llHdl->ma;
-    u_int8  myIrq=0, i, numRegs;
-    u_int32 inputsCausingIrqRaise=0, inputsCausingIrqFall=0;
+    if( llHdl->ntfPending == 0 )
+        llHdl->ntfFirst = now;
 
-    IDBGWRT_1((DBH, ">>> Z50_Irq:\n"));
-
-    /* how many registers to handle ? */
-    numRegs = (llHdl->d302i) ? CH_NUMBER : 1;
+    llHdl->ntfPending += edges;
 
-    for( i=0; i<numRegs; ++i ) {
-        /* for raising edge: get mask of inputs which caused irq */
-        inputsCausingIrqRaise = MREAD_D32( ma, llHdl->edgeRaiseReg+i*4 ) &
-            MREAD_D32( ma, llHdl->irqEdgeRaiseReg+i*4 );
+    if( (now - llHdl->ntfLast) >= llHdl->ntfHoldoffTicks ||
+        (llHdl->ntfThreshold && llHdl->ntfPending >= llHdl->ntfThreshold) ) {
+        sigSend( llHdl, llHdl->portChangeSig );
 
-        /* clear irq by setting corresponding bits */
-        MWRITE_D32( ma, llHdl->edgeRaiseReg+i*4, inputsCausingIrqRaise);
+        if( llHdl->histOn )
+            histAdd( &llHdl->histNtf, Z50_TIMESTAMP() - llHdl->ntfFirst );
 
-        /* save bits for user */
-        llHdl->edgeRaiseIrq[i] |= inputsCausingIrqRaise;
+        llHdl->ntfLast    = now;
+        llHdl->ntfPending = 0;
+    }
+}
 
-        /* same for falling edge */
-        inputsCausingIrqFall = MREAD_D32( ma, llHdl->edgeFallReg+i*4 ) &
-            MREAD_D32( ma, llHdl->irqEdgeFallReg+i*4 );
-        MWRITE_D32( ma, llHdl->edgeFallReg+i*4, inputsCausingIrqFall );
-        llHdl->edgeFallIrq[i] |= inputsCausingIrqFall;
+/**********************************************************************/
+/** Send deferred signal when holdoff expired (timer tick)
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void
+notifyTick( LL_HANDLE *llHdl )
+{
+    OSS_IRQ_STATE irqState;
+    u_int32 now;
 
-        /* this interrupt caused by GPIO controller ? */
-        if( inputsCausingIrqRaise || inputsCausingIrqFall ) {
-            myIrq = 1;
-        }
-    }
+    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
 
-    if( myIrq ) {
+    now = Z50_TIMESTAMP();
 
-        /* if requested send signal to application */
-        if( llHdl->portChangeSig ) {
-            OSS_SigSend( OSH, llHdl->portChangeSig );
-        }
+    if( llHdl->ntfPending && llHdl->portChangeSig &&
+        (now - llHdl->ntfLast) >= llHdl->ntfHoldoffTicks ) {
+        sigSend( llHdl, llHdl->portChangeSig );
 
-        llHdl->irqCount++;
+        if( llHdl->histOn )
+            histAdd( &llHdl->histNtf, now - llHdl->ntfFirst );
 
-        return( LL_IRQ_DEVICE );
+        llHdl->ntfLast    = now;
+        llHdl->ntfPending = 0;
     }
 
-    return( LL_IRQ_DEV_NOT );
+    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
 }
 
-/****************************** Z50_Info ***********************************/
-/** Get information about hardware and driver requirements
- *
- *  The following info codes are supported:
- *
- * \code
- *  Code                      Description
- *  ------------------------  -----------------------------
- *  LL_INFO_HW_CHARACTER      hardware characteristics
- *  LL_INFO_ADDRSPACE_COUNT   nr of required address spaces
- *  LL_INFO_ADDRSPACE         address space information
- *  LL_INFO_IRQ               interrupt required
- *  LL_INFO_LOCKMODE          process lock mode required
- * \endcode
- *
- *  The LL_INFO_HW_CHARACTER code returns all address and
- *  data modes (ORed) which are supported by the hardware
- *  (MDIS_MAxx, MDIS_MDxx).
- *
- *  The LL_INFO_ADDRSPACE_COUNT code returns the number
- *  of address spaces used by the driver.
- *
- *  The LL_INFO_ADDRSPACE code returns information about one
- *  specific address space (MDIS_MAxx, MDIS_MDxx). The returned
- *  data mode represents the widest hardware access used by
- *  the driver.
- *
- *  The LL_INFO_IRQ code returns whether the driver supports an
- *  interrupt routine (TRUE or FALSE).
- *
- *  The LL_INFO_LOCKMODE code returns which process locking
- *  mode the driver needs (LL_LOCK_xxx).
+/**********************************************************************/
+/** Count set bits
  *
- *  \param infoType    \IN  info code
- *  \param ...         \IN  argument(s)
+ *  \param mask       \IN  value
  *
- *  \return            \c 0 on success or error code
+ *  \return           number of bits set in mask
  */
-static int32 Z50_Info(
-   int32  infoType,
-   ...
-)
+static u_int32
+bitCount( u_int32 mask )
 {
-    int32   error = ERR_SUCCESS;
-    va_list argptr;
+    u_int32 n;
 
-    va_start(argptr, infoType );
+    for( n=0; mask; ++n )
+        mask &= mask - 1;
 
-    switch(infoType) {
-        /*-------------------------------+
-        |  hardware characteristics      |
-        |  (all addr/data modes ORed)   |
-        +-------------------------------*/
-        case LL_INFO_HW_CHARACTER:
-        {
-            u_int32 *addrModeP = va_arg(argptr, u_int32*);
-            u_int32 *dataModeP = va_arg(argptr, u_int32*);
+    return( n );
+}
 
-            *addrModeP = MDIS_MA08;
-            *dataModeP = MDIS_MD08 | MDIS_MD16;
-            break;
-        }
-        /*-------------------------------+
-        |  nr of required address spaces |
-        |  (total spaces used)           |
-        +-------------------------------*/
-        case LL_INFO_ADDRSPACE_COUNT:
-        {
-            u_int32 *nbrOfAddrSpaceP = va_arg(argptr, u_int32*);
+/**********************************************************************/
+/** Interrupt storm protection: set threshold
+ *
+ *  Threshold 0 switches the protection off and re-arms all quarantined
+ *  inputs.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param threshold  \IN  edges per input and window (0=off)
+ *
+ *  \return           \c 0 on success or error code
+ */
+static int32
+quarSet( LL_HANDLE *llHdl, u_int32 threshold )
+{
+    OSS_IRQ_STATE irqState;
+    u_int32 ch;
 
-            *nbrOfAddrSpaceP = ADDRSPACE_COUNT;
-            break;
-        }
-        /*-------------------------------+
-        |  address space type            |
-        |  (widest used data mode)       |
-        +-------------------------------*/
-        case LL_INFO_ADDRSPACE:
-        {
-            u_int32 addrSpaceIndex = va_arg(argptr, u_int32);
-            u_int32 *addrModeP = va_arg(argptr, u_int32*);
-            u_int32 *dataModeP = va_arg(argptr, u_int32*);
-            u_int32 *addrSizeP = va_arg(argptr, u_int32*);
+    OSS_SpinLockAcquire( OSH, llHdl->outLock );
+    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
 
-            if (addrSpaceIndex >= ADDRSPACE_COUNT)
-                error = ERR_LL_ILL_PARAM;
-            else {
-                *addrModeP = MDIS_MA24;
-                *dataModeP = MDIS_MD32;
-                *addrSizeP = ADDRSPACE_SIZE;
-            }
+    llHdl->quarThreshold = threshold;
+    llHdl->quarWinLeft   = llHdl->quarWinTicks;
+    OSS_MemFill( OSH, sizeof(llHdl->quarCnt), (char*)llHdl->quarCnt, 0 );
 
-            break;
+    if( threshold == 0 ) {
+        for( ch=0; ch<CH_NUMBER; ++ch ) {
+            if( llHdl->quarMask[ch] )
+                quarRearm( llHdl, ch, llHdl->quarMask[ch] );
         }
-        /*-------------------------------+
-        |   interrupt required           |
-        +-------------------------------*/
-        case LL_INFO_IRQ:
-        {
-            u_int32 *useIrqP = va_arg(argptr, u_int32*);
+    }
 
-            *useIrqP = USE_IRQ;
-            break;
-        }
-        /*-------------------------------+
-        |   process lock mode            |
-        +-------------------------------*/
-        case LL_INFO_LOCKMODE:
-        {
-            u_int32 *lockModeP = va_arg(argptr, u_int32*);
+    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
+    OSS_SpinLockRelease( OSH, llHdl->outLock );
 
-            *lockModeP = LL_LOCK_CALL;
-            break;
-        }
-        /*-------------------------------+
-        |   (unknown)                    |
-        +-------------------------------*/
-        default:
-          error = ERR_LL_ILL_PARAM;
+    if( threshold == 0 ) {
+        timerStop( llHdl, TMR_QUAR );
+        return( ERR_SUCCESS );
     }
 
-    va_end(argptr);
-    return(error);
+    return( timerStart( llHdl, TMR_QUAR ) );
 }
 
-/*******************************  Ident  ***********************************/
-/** Return ident string
+/**********************************************************************/
+/** Interrupt storm protection: count edges (called from interrupt)
  *
- *  \return            pointer to ident string
+ *  Inputs reaching the threshold within the current window are masked
+ *  in the interrupt enable registers. The mask set by the user is kept
+ *  and restored by quarRearm().
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel
+ *  \param mask       \IN  inputs with edge
  */
-static char* Ident( void )
+static void
+quarCheck( LL_HANDLE *llHdl, u_int32 ch, u_int32 mask )
 {
-    return( (char*) IdentString );
+    MACCESS ma = llHdl->ma;
+    u_int32 *cnt = llHdl->quarCnt[ch], bad = 0;
+    int i;
+
+    for( i=0; mask; mask >>= 1, ++i ) {
+        if( (mask & 1) && ++cnt[i] == llHdl->quarThreshold ) {
+            bad |= (u_int32)1 << i;
+            llHdl->quarLeft[ch][i] = llHdl->quarBackTicks;
+            llHdl->quarTotal[ch][i]++;
+        }
+    }
+
+    if( bad ) {
+        llHdl->quarMask[ch] |= bad;
+        llHdl->shIrqRaise[ch] &= ~bad;
+        llHdl->shIrqFall[ch]  &= ~bad;
+        MWRITE_D32( ma, REG_IRQ_EDGE_RAISE(llHdl)+ch*4,
+                    llHdl->shIrqRaise[ch] );
+        MWRITE_D32( ma, REG_IRQ_EDGE_FALL(llHdl)+ch*4,
+                    llHdl->shIrqFall[ch] );
+
+        IDBGWRT_1((DBH, " quarantine ch=%d inputs=0x%08x\n", ch, bad));
+    }
 }
 
-/********************************* Cleanup *********************************/
-/** Close all handles, free memory and return error code
+/**********************************************************************/
+/** Interrupt storm protection: timer tick (called with output lock held)
  *
- *  \warning The low-level handle is invalid after this function is called.
+ *  Restarts the rate window and re-arms inputs whose quarantine time
+ *  has elapsed.
  *
  *  \param llHdl      \IN  low-level handle
- *  \param retCode    \IN  return value
- *
- *  \return           \IN   retCode
  */
-static int32 Cleanup(
-   LL_HANDLE    *llHdl,
-   int32        retCode
-)
+static void
+quarTick( LL_HANDLE *llHdl )
 {
-    /*------------------------------+
-    |  close handles                |
-    +------------------------------*/
-    /* clean up desc */
-    if (llHdl->descHdl)
-        DESC_Exit(&llHdl->descHdl);
+    OSS_IRQ_STATE irqState;
+    u_int32 ch, mask, rearm;
+    int i;
 
-    /* clean up debug */
-    DBGEXIT((&DBH));
+    irqState = OSS_IrqMaskR( OSH, llHdl->irqHdl );
 
-    /*------------------------------+
-    |  free memory                  |
-    +------------------------------*/
-    /* free my handle */
-    OSS_MemFree(llHdl->osHdl, (int8*)llHdl, llHdl->memAlloc);
+    if( --llHdl->quarWinLeft == 0 ) {
+        llHdl->quarWinLeft = llHdl->quarWinTicks;
+        OSS_MemFill( OSH, sizeof(llHdl->quarCnt), (char*)llHdl->quarCnt, 0 );
+    }
 
-    /*------------------------------+
-    |  return error code            |
-    +------------------------------*/
-    return(retCode);
+    for( ch=0; ch<CH_NUMBER; ++ch ) {
+        if( (mask = llHdl->quarMask[ch]) == 0 )
+            continue;
+
+        rearm = 0;
+        for( i=0; i<IN_NUMBER; ++i ) {
+            if( (mask & ((u_int32)1 << i)) && --llHdl->quarLeft[ch][i] == 0 )
+                rearm |= (u_int32)1 << i;
+        }
+
+        if( rearm )
+            quarRearm( llHdl, ch, rearm );
+    }
+
+    OSS_IrqRestore( OSH, llHdl->irqHdl, irqState );
 }
 
 /**********************************************************************/
-/** Reset GPIO controller
+/** Interrupt storm protection: re-arm inputs (interrupt masked)
  *
- *  Sets the controller registers to default values:
- *  - all interrupt disabled
- *  - all outputs off
- *  - debouncing disabled
+ *  Edges latched during the quarantine are discarded, so the inputs do
+ *  not raise an interrupt immediately.
  *
  *  \param llHdl      \IN  low-level handle
+ *  \param ch         \IN  channel
+ *  \param mask       \IN  inputs to re-arm
  */
-
 static void
-gpioReset( LL_HANDLE *llHdl )
+quarRearm( LL_HANDLE *llHdl, u_int32 ch, u_int32 mask )
 {
     MACCESS ma = llHdl->ma;
-    int i, numRegs;
+    int i;
 
-    /* reset internal control logic (BIOC only) */
-    if( ! llHdl->d302i ) {
-        MWRITE_D32( ma, llHdl->controlReg, 1 );
+    llHdl->quarMask[ch] &= ~mask;
+
+    for( i=0; i<IN_NUMBER; ++i ) {
+        if( mask & ((u_int32)1 << i) )
+            llHdl->quarCnt[ch][i] = 0;
     }
 
-    numRegs = (llHdl->d302i) ? CH_NUMBER : 1;
+    MWRITE_D32( ma, REG_EDGE_RAISE(llHdl)+ch*4, mask );
+    MWRITE_D32( ma, REG_EDGE_FALL(llHdl)+ch*4, mask );
 
-    /* for all registers */
-    for( i=0; i<numRegs; ++i ) {
+    llHdl->shIrqRaise[ch] = llHdl->reqIrqRaise[ch] & ~llHdl->quarMask[ch];
+    llHdl->shIrqFall[ch]  = llHdl->reqIrqFall[ch] & ~llHdl->quarMask[ch];
+    MWRITE_D32( ma, REG_IRQ_EDGE_RAISE(llHdl)+ch*4, llHdl->shIrqRaise[ch] );
+    MWRITE_D32( ma, REG_IRQ_EDGE_FALL(llHdl)+ch*4, llHdl->shIrqFall[ch] );
 
-        /* disable all interrupts */
-        MWRITE_D32( ma, llHdl->irqEdgeRaiseReg+i*4, 0 );
-        MWRITE_D32( ma, llHdl->irqEdgeFallReg+i*4, 0 );
+    DBGWRT_2((DBH, " quarantine end ch=%d inputs=0x%08x\n", ch, mask));
+}
 
-        /* switch off all outputs */
-        MWRITE_D32( ma, llHdl->outputReg+i*4, 0 );
+/**********************************************************************/
+/** Convert milliseconds to driver timer ticks (rounded up, at least 1)
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param msec       \IN  time [ms]
+ *
+ *  \return           number of timer ticks
+ */
+static u_int32
+msToTmrTicks( LL_HANDLE *llHdl, u_int32 msec )
+{
+    u_int32 ticks = (msec + llHdl->timerPeriod - 1) / llHdl->timerPeriod;
 
-        /* reset edge registers */
-        MWRITE_D32( ma, llHdl->edgeRaiseReg+i*4, 0xffffffff );
-        MWRITE_D32( ma, llHdl->edgeFallReg+i*4,  0xffffffff );
-    }
+    return( ticks ? ticks : 1 );
+}
 
-    /* disable debouncer */
-    numRegs = (llHdl->d302i) ? CH_NUMBER : 32;
+/**********************************************************************/
+/** Add value to log2 histogram
+ *
+ *  \param h          \IN  histogram
+ *  \param value      \IN  value [timestamp ticks]
+ */
+static void
+histAdd( HIST *h, u_int32 value )
+{
+    u_int32 n = 0, v = value;
 
-    for( i=0; i<numRegs; ++i ) {
-        MWRITE_D32( ma, llHdl->debounceReg+i*4, 0 );
-    }
+    while( v >>= 1 )
+        n++;
+
+    h->bucket[n]++;
+    h->count++;
+
+    if( value > h->max )
+        h->max = value;
+}
+
+/**********************************************************************/
+/** Send signal and count result (called from Z50_Irq or with
+ *  interrupts masked)
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param sig        \IN  signal handle
+ */
+static void
+sigSend( LL_HANDLE *llHdl, OSS_SIG_HANDLE *sig )
+{
+    if( OSS_SigSend( OSH, sig ) )
+        llHdl->stats.sigFailed++;
+    else
+        llHdl->stats.sigSent++;
 }
@@ -133,7 +133,8 @@ int main(int argc, char *argv[])
     |  output values      |
     +--------------------*/
     for( i=0; i<maxCnt; ++i ) {
-        int32 raise, fall;
+        Z50_STATUS_PB st;
+        M_SG_BLOCK    blk;
         u_int32 out;
 
         if( bitShift )
@@ -144,15 +145,16 @@ int main(int argc, char *argv[])
         M_write( path, out );
 
         UOS_Delay( 10 );
-        M_read( path, &inp );
 
-        M_getstat( path, Z50_EDGE_RAISE, &raise );
-        M_getstat( path, Z50_EDGE_FALL, &fall );
+        /* inputs and edges with one call */
+        blk.size = sizeof( st );
+        blk.data = (void*)&st;
+        M_getstat( path, Z50_BLK_STATUS, (int32*)&blk );
 
         printf( "%2d: Out: %s  In: %s (0x%04x)  raise: 0x%04x  fall: 0x%04x  "
                 "IRQs: %d\n",
-                out, bitString( buf1, out, 5 ), bitString( buf2, inp, 5 ),
-                inp, raise, fall, G_sigCount );
+                out, bitString( buf1, out, 5 ), bitString( buf2, st.input, 5 ),
+                st.input, st.raise, st.fall, G_sigCount );
 
         UOS_Delay( DELAY );
     }
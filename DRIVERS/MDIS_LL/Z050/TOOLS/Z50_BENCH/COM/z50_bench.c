@@ -0,0 +1,406 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                    Z50_BENCH                       ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z50_bench.c
+ *       \author ulrich.bogensperger@men.de
+ *
+ *        \brief Throughput and latency benchmark for the Z50 driver
+ *
+ *  Calls one driver function in a tight loop and reports calls per
+ *  second and latency percentiles. Every test runs twice: an untimed
+ *  pass for the throughput, and a pass that takes a timestamp around
+ *  every call for the latencies. The results are printed as CSV, one
+ *  line per test, to compare driver and MDIS releases.
+ *
+ *  Built with Z50_SIM (see TOOLS/Z50_SIM) the program runs against the
+ *  register-level simulator. It then also reports the register accesses
+ *  per call and offers the tests isr/isrnot, which call the interrupt
+ *  routine for an edge of the device and of another device.
+ *
+ *  Latencies need a fine clock: on Linux and in the simulator
+ *  clock_gettime() is used, elsewhere the millisecond timer of UOS.
+ *
+ *     Required: libraries: mdis_api, usr_oss
+ *     \switches Z50_SIM
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2004-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/z50_drv.h>
+
+#ifdef Z50_SIM
+# include "z50_sim.h"
+# define ERRNO_GET()    errno
+#else
+# include <MEN/usr_oss.h>
+# define ERRNO_GET()    UOS_ErrnoGet()
+#endif
+
+#if defined(LINUX) || defined(Z50_SIM)
+# include <time.h>
+# define FINE_CLOCK
+#endif
+
+static const char IdentString[]=MENT_XSTR(MAK_REVISION);
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define OPS_DEFAULT     100000      /* calls per test */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+typedef struct {
+    const char *name;                           /* test name */
+    int32 (*fct)( MDIS_PATH path, u_int32 i );  /* one call */
+} BENCH_TEST;
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void usage(void);
+static char *optGet( int argc, char *argv[], const char *opt );
+static u_int64 timeNs( void );
+static int cmpU32( const void *a, const void *b );
+static int runTest( MDIS_PATH path, const BENCH_TEST *t, u_int32 ops );
+static int32 opRead( MDIS_PATH path, u_int32 i );
+static int32 opWrite( MDIS_PATH path, u_int32 i );
+static int32 opPorts( MDIS_PATH path, u_int32 i );
+static int32 opEdge( MDIS_PATH path, u_int32 i );
+static int32 opBlkRead( MDIS_PATH path, u_int32 i );
+static int32 opBlkWrite( MDIS_PATH path, u_int32 i );
+#ifdef Z50_SIM
+static int32 opIsr( MDIS_PATH path, u_int32 i );
+static int32 opIsrNot( MDIS_PATH path, u_int32 i );
+#endif
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static const BENCH_TEST G_tests[] = {
+    { "read",     opRead },
+    { "write",    opWrite },
+    { "ports",    opPorts },
+    { "edge",     opEdge },
+    { "blkread",  opBlkRead },
+    { "blkwrite", opBlkWrite },
+#ifdef Z50_SIM
+    { "isr",      opIsr },
+    { "isrnot",   opIsrNot },
+#endif
+    { NULL, NULL }
+};
+
+static u_int32 G_mask;          /* outputs toggled by write tests */
+static u_int32 *G_lat;          /* latencies of one test [ns] */
+static u_int32 G_buf[Z50_MAX_CH];
+
+
+/********************************* usage ***********************************/
+/**  Print program usage
+ */
+static void usage(void)
+{
+    printf("Usage: z50_bench [<opts>] <device> [<opts>]\n");
+    printf("Function: Throughput and latency benchmark for Z50 driver\n");
+    printf("Options:\n");
+    printf("  device       device name..................... [none]    \n");
+    printf("  -c=<chan>    channel number (0..3)........... [0]       \n");
+    printf("  -n=<ops>     calls per test.................. [%d]\n",
+           OPS_DEFAULT);
+    printf("  -m=<mask>    outputs toggled by write tests.. [0]       \n");
+    printf("  -t=<test>    run only this test.............. [all]     \n");
+    printf("\n");
+    printf("Tests: read (M_read), write (M_write), ports (Z50_SET_PORTS/\n");
+    printf("       Z50_CLR_PORTS), edge (Z50_EDGE_RAISE), blkread\n");
+    printf("       (M_getblock), blkwrite (M_setblock, channel 0 only)\n");
+#ifdef Z50_SIM
+    printf("       isr (interrupt of device), isrnot (other device)\n");
+    printf("Device: bioc, d302i or d302i_gip (simulated)\n");
+#endif
+    printf("Output: test,ops,ops_per_s,min_ns,p50_ns,p90_ns,p99_ns,max_ns");
+#ifdef Z50_SIM
+    printf(",reads_per_op,writes_per_op");
+#endif
+    printf("\n\n");
+    printf("Copyright 2004-2019, MEN Mikro Elektronik GmbH\n%s\n", IdentString);
+}
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return           success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+    const BENCH_TEST *t;
+    MDIS_PATH path;
+    char      *device, *str, *test;
+    int32     chan, i;
+    u_int32   ops;
+    int       ret = 0;
+
+    /*--------------------+
+    |  get arguments      |
+    +--------------------*/
+    for (device=NULL, i=1; i<argc; i++)
+        if (*argv[i] != '-') {
+            device = argv[i];
+            break;
+        }
+
+    if (!device || optGet(argc, argv, "?")) {
+        usage();
+        return(1);
+    }
+
+    chan   = ((str = optGet(argc, argv, "c=")) ? atoi(str) : 0);
+    ops    = ((str = optGet(argc, argv, "n=")) ?
+              strtoul(str, NULL, 0) : OPS_DEFAULT);
+    G_mask = ((str = optGet(argc, argv, "m=")) ? strtoul(str, NULL, 0) : 0);
+    test   = optGet(argc, argv, "t=");
+
+    if( ops == 0 || (G_lat = malloc( ops * sizeof(u_int32) )) == NULL ) {
+        printf("*** can't allocate latency buffer\n");
+        return(1);
+    }
+
+    /*--------------------+
+    |  open path          |
+    +--------------------*/
+    if ((path = M_open(device)) < 0) {
+        printf("*** can't open: %s\n", M_errstring(ERRNO_GET()));
+        free( G_lat );
+        return(1);
+    }
+
+    if ((M_setstat(path, M_MK_CH_CURRENT, chan)) < 0 ||
+        (M_setstat(path, Z50_GETBLOCK_MODE, Z50_GBM_INPUT)) < 0 ||
+        (M_setstat(path, Z50_SETBLOCK_MODE, Z50_SBM_OUTPUT)) < 0) {
+        printf("*** can't setstat: %s\n", M_errstring(ERRNO_GET()));
+        ret = 1;
+        goto ABORT;
+    }
+
+    /*--------------------+
+    |  run tests          |
+    +--------------------*/
+    printf("test,ops,ops_per_s,min_ns,p50_ns,p90_ns,p99_ns,max_ns");
+#ifdef Z50_SIM
+    printf(",reads_per_op,writes_per_op");
+#endif
+    printf("\n");
+
+    for( t=G_tests; t->name && !ret; t++ ) {
+        if( test && strcmp( test, t->name ) )
+            continue;
+        ret = runTest( path, t, ops );
+    }
+
+ABORT:
+    if (M_close(path) < 0) {
+        printf("*** can't close: %s\n", M_errstring(ERRNO_GET()));
+        ret = 1;
+    }
+
+    free( G_lat );
+    return(ret);
+}
+
+/********************************* optGet **********************************/
+/** Find option "-<opt>" in argument list
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *  \param opt        \IN  option, e.g. "c=" or "?"
+ *
+ *  \return           value after "=", "" for flags, NULL if not given
+ */
+static char *optGet( int argc, char *argv[], const char *opt )
+{
+    size_t len = strlen( opt );
+    int i;
+
+    for( i=1; i<argc; i++ )
+        if( argv[i][0] == '-' && !strncmp( argv[i]+1, opt, len ) )
+            return argv[i] + 1 + len;
+
+    return NULL;
+}
+
+/********************************* timeNs **********************************/
+/** Get timestamp
+ *
+ *  \return           time [ns]
+ */
+static u_int64 timeNs( void )
+{
+#ifdef FINE_CLOCK
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (u_int64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return (u_int64)UOS_MsecTimerGet() * 1000000;
+#endif
+}
+
+/***************************************************************************/
+static int cmpU32( const void *a, const void *b )
+{
+    u_int32 x = *(const u_int32*)a, y = *(const u_int32*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/********************************* runTest *********************************/
+/** Run one test and print result line
+ *
+ *  \param path       \IN  MDIS path
+ *  \param t          \IN  test
+ *  \param ops        \IN  number of calls
+ *
+ *  \return           0 on success, 1 on error
+ */
+static int runTest( MDIS_PATH path, const BENCH_TEST *t, u_int32 ops )
+{
+    u_int64 start, end, ns;
+    u_int32 i;
+#ifdef Z50_SIM
+    Z50SIM_COUNTERS cnt;
+#endif
+
+    /* throughput */
+#ifdef Z50_SIM
+    Z50SIM_Counters( NULL, 1 );
+#endif
+    start = timeNs();
+    for( i=0; i<ops; i++ ) {
+        if( t->fct( path, i ) < 0 ) {
+            printf("*** %s failed: %s\n", t->name,
+                   M_errstring(ERRNO_GET()));
+            return 1;
+        }
+    }
+    end = timeNs();
+#ifdef Z50_SIM
+    Z50SIM_Counters( &cnt, 0 );
+#endif
+
+    /* latencies */
+    for( i=0; i<ops; i++ ) {
+        ns = timeNs();
+        t->fct( path, i );
+        G_lat[i] = (u_int32)(timeNs() - ns);
+    }
+    qsort( G_lat, ops, sizeof(u_int32), cmpU32 );
+
+    ns = end - start;
+    printf("%s,%u,%.0f,%u,%u,%u,%u,%u", t->name, ops,
+           ns ? (double)ops * 1e9 / (double)ns : 0.0,
+           G_lat[0], G_lat[ops/2], G_lat[(u_int64)ops*90/100],
+           G_lat[(u_int64)ops*99/100], G_lat[ops-1]);
+#ifdef Z50_SIM
+    printf(",%.2f,%.2f", (double)cnt.regRead / ops,
+           (double)cnt.regWrite / ops);
+#endif
+    printf("\n");
+
+    return 0;
+}
+
+/***************************************************************************/
+/* test functions: one driver call each, i = call number                   */
+/***************************************************************************/
+static int32 opRead( MDIS_PATH path, u_int32 i )
+{
+    int32 value;
+
+    (void)i;
+
+    return M_read( path, &value );
+}
+
+static int32 opWrite( MDIS_PATH path, u_int32 i )
+{
+    return M_write( path, (i & 1) ? G_mask : 0 );
+}
+
+static int32 opPorts( MDIS_PATH path, u_int32 i )
+{
+    return M_setstat( path, (i & 1) ? Z50_CLR_PORTS : Z50_SET_PORTS, G_mask );
+}
+
+static int32 opEdge( MDIS_PATH path, u_int32 i )
+{
+    int32 value;
+
+    (void)i;
+
+    return M_getstat( path, Z50_EDGE_RAISE, &value );
+}
+
+static int32 opBlkRead( MDIS_PATH path, u_int32 i )
+{
+    (void)i;
+    return M_getblock( path, (u_int8*)G_buf, sizeof(G_buf) );
+}
+
+static int32 opBlkWrite( MDIS_PATH path, u_int32 i )
+{
+    G_buf[0] = (i & 1) ? G_mask : 0;
+    return M_setblock( path, (u_int8*)G_buf, sizeof(u_int32) );
+}
+
+#ifdef Z50_SIM
+/* the interrupt routine runs when the edge is latched */
+static int32 opIsr( MDIS_PATH path, u_int32 i )
+{
+    if( i == 0 ) {
+        M_setstat( path, Z50_IRQ_EDGE_RAISE, 1 );
+        M_setstat( path, Z50_IRQ_EDGE_FALL, 1 );
+        M_setstat( path, M_MK_IRQ_ENABLE, 1 );
+    }
+    Z50SIM_Input( 0, 1, ~i & 1 );
+    return 0;
+}
+
+static int32 opIsrNot( MDIS_PATH path, u_int32 i )
+{
+    (void)path;
+    (void)i;
+    return Z50SIM_IrqInject() < 0 ? -1 : 0;
+}
+#endif
@@ -0,0 +1,565 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z50_DBCALIB                      ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z50_dbcalib.c
+ *       \author ulrich.bogensperger@men.de
+ *
+ *        \brief Debounce auto-calibration
+ *
+ *  Switches debouncing off, captures the raw edges of the selected inputs
+ *  with their driver timestamps (Z50_BLK_EVENTS, descriptor key
+ *  Z50_EVENT_DEPTH must be set) while the contacts are operated, and
+ *  groups them into bursts: edges of one input closer than the quiet gap
+ *  (-g) belong to the same burst. The burst duration (first
+ *  to last edge) is the bounce time of the contact.
+ *
+ *  From the longest burst plus a safety margin (-p) the tool computes the
+ *  minimal Z50_BLK_DEBOUNCE value and programs it per input (BIOC) or per
+ *  channel (D302i, maximum of its inputs). Inputs without bursts keep
+ *  their previous value.
+ *
+ *  The measurement is only as fine as the driver timestamps, therefore
+ *  the tool refuses to run if a timestamp tick is longer than the debounce
+ *  unit (50us), e.g. with the OSS tick of non-Linux builds; build the
+ *  driver with Z50_TIMESTAMP for a fine clock there. One tick is added to
+ *  the measured maximum. Edges between two interrupts are merged into one
+ *  event, so use a large -p on slow systems.
+ *
+ *  The interrupt edge masks of all channels and the interrupt enable are
+ *  restored on exit.
+ *
+ *  Built with Z50_SIM (see TOOLS/Z50_SIM) every input bounces
+ *  1+input%4 times at (100+25*input)us intervals every POLL_MS.
+ *
+ *     Required: libraries: mdis_api, usr_oss
+ *     \switches Z50_SIM
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2004-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/z50_drv.h>
+
+#ifdef Z50_SIM
+# include "z50_sim.h"
+# define ERRNO_GET()    errno
+#else
+# include <MEN/usr_oss.h>
+# define ERRNO_GET()    UOS_ErrnoGet()
+#endif
+
+static const char IdentString[]=MENT_XSTR(MAK_REVISION);
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define TIME_DEFAULT    10          /* capture time [s] */
+#define GAP_DEFAULT     20          /* quiet gap between bursts [ms] */
+#define MARGIN_DEFAULT  150         /* safety margin [%] */
+#define POLL_MS         100         /* event ring poll period [ms] */
+#define MAX_BURSTS      1024        /* stored bursts per input */
+#define EVT_RECS        256         /* events per Z50_BLK_EVENTS call */
+#define DB_UNIT_US      50          /* debounce register unit [us] */
+#define DB_MAX          0xffff      /* max. debounce register value */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** burst tracking of one input */
+typedef struct {
+    int     open;                   /* burst in progress */
+    u_int32 first;                  /* timestamp of first edge [ticks] */
+    u_int32 last;                   /* timestamp of last edge [ticks] */
+    u_int32 edges;                  /* edges in current burst */
+    u_int32 bursts;                 /* finished bursts */
+    u_int32 edgesTotal;             /* edges in finished bursts */
+    u_int32 dur[MAX_BURSTS];        /* burst durations [ticks] */
+} BURST;
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void usage(void);
+static char *optGet( int argc, char *argv[], const char *opt );
+static int capture( MDIS_PATH path, u_int32 chan, u_int32 mask,
+                    u_int32 gapMs, int flush );
+static void burstEdge( BURST *b, u_int32 time, u_int32 gap );
+static void burstClose( BURST *b );
+static int cmpU32( const void *a, const void *b );
+static u_int32 ticksUs( u_int32 ticks );
+static int32 setDebounce( MDIS_PATH path, int input, u_int32 value );
+static int32 getDebounce( MDIS_PATH path, int input, u_int32 *valueP );
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static BURST   G_burst[Z50_NUM_INPUTS];
+static u_int8  G_evtBuf[sizeof(Z50_EVENT_HDR) + EVT_RECS*sizeof(Z50_EVENT)];
+static u_int32 G_tickRate;          /* timestamp rate [1/s] */
+static u_int32 G_lost;              /* events lost during capture */
+
+
+/********************************* usage ***********************************/
+/**  Print program usage
+ */
+static void usage(void)
+{
+    printf("Usage: z50_dbcalib [<opts>] <device> [<opts>]\n");
+    printf("Function: Measure contact bounce and program minimal debounce\n");
+    printf("          (operate the contacts during the capture time)\n");
+    printf("Options:\n");
+    printf("  device       device name..................... [none]    \n");
+    printf("  -c=<chan>    channel number (0..3)........... [0]       \n");
+    printf("  -m=<mask>    inputs to calibrate............. [0xffffffff]\n");
+    printf("  -t=<s>       capture time.................... [%d]\n",
+           TIME_DEFAULT);
+    printf("  -g=<ms>      quiet gap between bursts........ [%d]\n",
+           GAP_DEFAULT);
+    printf("  -p=<%%>       safety margin................... [%d]\n",
+           MARGIN_DEFAULT);
+    printf("  -n           measure only, don't program..... [no]      \n");
+#ifdef Z50_SIM
+    printf("Device: bioc, d302i or d302i_gip (simulated, bouncing inputs)\n");
+#endif
+    printf("\n");
+    printf("Copyright 2004-2019, MEN Mikro Elektronik GmbH\n%s\n", IdentString);
+}
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return           success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+    MDIS_PATH  path;
+    BURST     *b;
+    char      *device, *str;
+    int32      i, numCh;
+    u_int32    chan, mask, secs, gapMs, margin, loop, n, maxDur, us, db;
+    u_int32    dbOld[Z50_NUM_INPUTS], dbNew[Z50_NUM_INPUTS];
+    u_int32    chMax = 0, chUsed = 0, numDb;
+    int32      irqEnOld, raiseOld[Z50_MAX_CH], fallOld[Z50_MAX_CH];
+    int        d302i, dryRun, ret = 0;
+
+    /*--------------------+
+    |  get arguments      |
+    +--------------------*/
+    for (device=NULL, i=1; i<argc; i++)
+        if (*argv[i] != '-') {
+            device = argv[i];
+            break;
+        }
+
+    if (!device || optGet(argc, argv, "?")) {
+        usage();
+        return(1);
+    }
+
+    chan   = ((str = optGet(argc, argv, "c=")) ? atoi(str) : 0);
+    mask   = ((str = optGet(argc, argv, "m=")) ?
+              strtoul(str, NULL, 0) : 0xffffffff);
+    secs   = ((str = optGet(argc, argv, "t=")) ? atoi(str) : TIME_DEFAULT);
+    gapMs  = ((str = optGet(argc, argv, "g=")) ? atoi(str) : GAP_DEFAULT);
+    margin = ((str = optGet(argc, argv, "p=")) ? atoi(str) : MARGIN_DEFAULT);
+    dryRun = (optGet(argc, argv, "n") != NULL);
+
+    /*--------------------+
+    |  open path          |
+    +--------------------*/
+#ifdef Z50_SIM
+    Z50SIM_DescSet( "Z50_EVENT_DEPTH", EVT_RECS );
+#endif
+    if ((path = M_open(device)) < 0) {
+        printf("*** can't open: %s\n", M_errstring(ERRNO_GET()));
+        return(1);
+    }
+
+    /* D302i has one debouncer per channel, BIOC one per input */
+    if ((M_getstat(path, M_LL_CH_NUMBER, &numCh)) < 0 ||
+        (M_setstat(path, M_MK_CH_CURRENT, chan)) < 0) {
+        printf("*** can't setup channel: %s\n", M_errstring(ERRNO_GET()));
+        ret = 1;
+        goto ABORT;
+    }
+    d302i = (numCh > 1);
+    numDb = d302i ? 1 : Z50_NUM_INPUTS;
+    if( numCh > Z50_MAX_CH )
+        numCh = Z50_MAX_CH;
+
+    /* save interrupt setup, M_MK_IRQ_ENABLE=0 may clear all channels */
+    if ((M_getstat(path, M_MK_IRQ_ENABLE, &irqEnOld)) < 0) {
+        printf("*** can't getstat: %s\n", M_errstring(ERRNO_GET()));
+        ret = 1;
+        goto ABORT;
+    }
+    for( i=0; i<numCh; i++ ) {
+        if ((M_setstat(path, M_MK_CH_CURRENT, i)) < 0 ||
+            (M_getstat(path, Z50_IRQ_EDGE_RAISE, &raiseOld[i])) < 0 ||
+            (M_getstat(path, Z50_IRQ_EDGE_FALL, &fallOld[i])) < 0) {
+            printf("*** can't getstat: %s\n", M_errstring(ERRNO_GET()));
+            ret = 1;
+            goto ABORT;
+        }
+    }
+    M_setstat(path, M_MK_CH_CURRENT, chan);
+
+    /* switch debouncing off, interrupt on both edges */
+    for( n=0; n<numDb; n++ ) {
+        if( !d302i && !(mask & ((u_int32)1 << n)) )
+            continue;
+        if( getDebounce( path, n, &dbOld[n] ) < 0 ||
+            setDebounce( path, n, 0 ) < 0 ) {
+            printf("*** can't set debounce: %s\n", M_errstring(ERRNO_GET()));
+            ret = 1;
+            goto ABORT;
+        }
+    }
+
+    if ((M_setstat(path, Z50_IRQ_EDGE_RAISE, mask)) < 0 ||
+        (M_setstat(path, Z50_IRQ_EDGE_FALL, mask)) < 0 ||
+        (M_setstat(path, M_MK_IRQ_ENABLE, 1)) < 0) {
+        printf("*** can't setstat: %s\n", M_errstring(ERRNO_GET()));
+        ret = 1;
+        goto CLEANUP;
+    }
+
+    /*--------------------+
+    |  capture            |
+    +--------------------*/
+    if( capture( path, chan, 0, gapMs, 1 ) < 0 ) {
+        ret = 1;
+        goto CLEANUP;
+    }
+
+    /* OSS tick timestamps can't resolve bounce times */
+    if( G_tickRate < 1000000 / DB_UNIT_US ) {
+        printf("*** timestamp resolution %u us is coarser than the debounce "
+               "unit, build the driver with Z50_TIMESTAMP\n", ticksUs( 1 ));
+        ret = 1;
+        goto CLEANUP;
+    }
+
+    printf("Capturing for %us, operate the contacts now...\n", secs);
+
+    for( loop=0; loop < secs * 1000 / POLL_MS; loop++ ) {
+#ifdef Z50_SIM
+        for( n=0; n<Z50_NUM_INPUTS; n++ )
+            if( mask & ((u_int32)1 << n) )
+                Z50SIM_Bounce( chan, (u_int32)1 << n, loop & 1 ? 0 : ~0,
+                               1 + n % 4, 100 + 25 * n );
+        Z50SIM_Run( POLL_MS * 1000 );
+#else
+        UOS_Delay( POLL_MS );
+#endif
+        if( capture( path, chan, mask, gapMs, 0 ) < 0 ) {
+            ret = 1;
+            goto CLEANUP;
+        }
+    }
+
+    for( n=0; n<Z50_NUM_INPUTS; n++ )
+        burstClose( &G_burst[n] );
+
+    /*--------------------+
+    |  evaluate           |
+    +--------------------*/
+    if( G_lost )
+        printf("*** %u events lost, results may be too short\n", G_lost);
+
+    printf("input,bursts,edges_per_burst,min_us,p50_us,p99_us,max_us,"
+           "debounce\n");
+
+    for( n=0; n<Z50_NUM_INPUTS; n++ ) {
+        b = &G_burst[n];
+        dbNew[n] = 0;
+
+        if( !(mask & ((u_int32)1 << n)) || b->bursts == 0 )
+            continue;
+
+        i = b->bursts < MAX_BURSTS ? b->bursts : MAX_BURSTS;
+        qsort( b->dur, i, sizeof(u_int32), cmpU32 );
+
+        /* add one tick unless all bursts were single edges */
+        maxDur = b->dur[i-1];
+        if( b->edgesTotal > b->bursts )
+            maxDur++;
+
+        us = (u_int32)((u_int64)ticksUs( maxDur ) * margin / 100);
+        db = (us + DB_UNIT_US - 1) / DB_UNIT_US;
+        dbNew[n] = db > DB_MAX ? DB_MAX : db;
+
+        printf("%u,%u,%u.%02u,%u,%u,%u,%u,%u\n", n, b->bursts,
+               b->edgesTotal / b->bursts,
+               b->edgesTotal % b->bursts * 100 / b->bursts,
+               ticksUs( b->dur[0] ),
+               ticksUs( b->dur[(i-1) / 2] ),
+               ticksUs( b->dur[(i-1) * 99 / 100] ),
+               ticksUs( b->dur[i-1] ), dbNew[n]);
+
+        if( dbNew[n] >= chMax )
+            chMax = dbNew[n];
+        chUsed = 1;
+    }
+
+    if( !chUsed )
+        printf("*** no edges captured\n");
+
+    /*--------------------+
+    |  program debounce   |
+    +--------------------*/
+    if( d302i ) {
+        printf("channel %u: debounce %u (%u us)%s\n", chan, chMax,
+               chMax * DB_UNIT_US, dryRun ? " (not programmed)" : "");
+        dbNew[0] = chMax;
+    }
+
+CLEANUP:
+    if( !irqEnOld )
+        M_setstat(path, M_MK_IRQ_ENABLE, 0);
+
+    for( i=0; i<numCh; i++ ) {
+        if ((M_setstat(path, M_MK_CH_CURRENT, i)) < 0 ||
+            (M_setstat(path, Z50_IRQ_EDGE_RAISE, raiseOld[i])) < 0 ||
+            (M_setstat(path, Z50_IRQ_EDGE_FALL, fallOld[i])) < 0) {
+            printf("*** can't restore irq setup: %s\n",
+                   M_errstring(ERRNO_GET()));
+            ret = 1;
+        }
+    }
+    M_setstat(path, M_MK_CH_CURRENT, chan);
+
+    for( n=0; n<numDb; n++ ) {
+        if( !d302i && !(mask & ((u_int32)1 << n)) )
+            continue;
+
+        /* keep previous value on error, dry run or without bursts */
+        db = (ret || dryRun || !(d302i ? chUsed : G_burst[n].bursts)) ?
+            dbOld[n] : dbNew[n];
+
+        if( setDebounce( path, n, db ) < 0 ) {
+            printf("*** can't set debounce: %s\n", M_errstring(ERRNO_GET()));
+            ret = 1;
+        }
+    }
+
+ABORT:
+    if (M_close(path) < 0) {
+        printf("*** can't close: %s\n", M_errstring(ERRNO_GET()));
+        ret = 1;
+    }
+
+    return(ret);
+}
+
+/********************************* capture *********************************/
+/** Read all queued edge events and assign them to bursts
+ *
+ *  \param path       \IN  MDIS path
+ *  \param chan       \IN  channel to evaluate
+ *  \param mask       \IN  inputs to evaluate
+ *  \param gapMs      \IN  quiet gap between bursts [ms]
+ *  \param flush      \IN  discard events if 1
+ *
+ *  \return           0 on success, -1 on error
+ */
+static int capture( MDIS_PATH path, u_int32 chan, u_int32 mask,
+                    u_int32 gapMs, int flush )
+{
+    Z50_EVENT_HDR *hdr = (Z50_EVENT_HDR*)G_evtBuf;
+    Z50_EVENT *evt = (Z50_EVENT*)(hdr + 1);
+    M_SG_BLOCK blk;
+    u_int32 i, n, bit, gap;
+
+    do {
+        blk.data = G_evtBuf;
+        blk.size = sizeof(G_evtBuf);
+
+        if( M_getstat( path, Z50_BLK_EVENTS, (int32*)&blk ) < 0 ) {
+            printf("*** can't get events: %s\n", M_errstring(ERRNO_GET()));
+            return -1;
+        }
+
+        G_tickRate = hdr->tickRate;
+        if( flush )
+            continue;
+
+        G_lost += hdr->lost;
+        gap = (u_int32)((u_int64)gapMs * G_tickRate / 1000);
+
+        for( i=0; i<hdr->count; i++ ) {
+            if( evt[i].ch != chan )
+                continue;
+
+            for( n=0; n<Z50_NUM_INPUTS; n++ ) {
+                bit = (u_int32)1 << n;
+                if( (evt[i].raise | evt[i].fall) & mask & bit )
+                    burstEdge( &G_burst[n], evt[i].time, gap );
+            }
+        }
+    } while( hdr->pending );
+
+    return 0;
+}
+
+/********************************* burstEdge *******************************/
+/** Add edge to burst, close the previous burst after a quiet gap
+ *
+ *  \param b          \IN  burst tracking of input
+ *  \param time       \IN  timestamp of edge [ticks]
+ *  \param gap        \IN  quiet gap between bursts [ticks]
+ */
+static void burstEdge( BURST *b, u_int32 time, u_int32 gap )
+{
+    if( b->open && time - b->last > gap )
+        burstClose( b );
+
+    if( !b->open ) {
+        b->open  = 1;
+        b->first = time;
+        b->edges = 0;
+    }
+
+    b->last = time;
+    b->edges++;
+}
+
+/********************************* burstClose ******************************/
+/** Finish burst in progress
+ *
+ *  \param b          \IN  burst tracking of input
+ */
+static void burstClose( BURST *b )
+{
+    if( !b->open )
+        return;
+
+    if( b->bursts < MAX_BURSTS )
+        b->dur[b->bursts] = b->last - b->first;
+
+    b->bursts++;
+    b->edgesTotal += b->edges;
+    b->open = 0;
+}
+
+/********************************* cmpU32 **********************************/
+/** qsort() compare function for u_int32
+ */
+static int cmpU32( const void *a, const void *b )
+{
+    u_int32 x = *(const u_int32*)a, y = *(const u_int32*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/********************************* ticksUs *********************************/
+/** Convert driver timestamp difference to microseconds
+ *
+ *  \param ticks      \IN  time [ticks]
+ *
+ *  \return           time [us]
+ */
+static u_int32 ticksUs( u_int32 ticks )
+{
+    return G_tickRate ?
+        (u_int32)((u_int64)ticks * 1000000 / G_tickRate) : 0;
+}
+
+/********************************* optGet **********************************/
+/** Find option "-<opt>" in argument list
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *  \param opt        \IN  option, e.g. "c=" or "?"
+ *
+ *  \return           value after "=", "" for flags, NULL if not given
+ */
+static char *optGet( int argc, char *argv[], const char *opt )
+{
+    size_t len = strlen( opt );
+    int i;
+
+    for( i=1; i<argc; i++ )
+        if( argv[i][0] == '-' && !strncmp( argv[i]+1, opt, len ) )
+            return argv[i] + 1 + len;
+
+    return NULL;
+}
+
+/********************************* setDebounce *****************************/
+/** Set debouncer
+ *
+ *  \param path       \IN  MDIS path
+ *  \param input      \IN  input number (ignored on D302i)
+ *  \param value      \IN  debounce time [50us]
+ *
+ *  \return           0 on success, -1 on error
+ */
+static int32 setDebounce( MDIS_PATH path, int input, u_int32 value )
+{
+    Z50_DEBOUNCE_PB db;
+    M_SG_BLOCK      blk;
+
+    db.input = input;
+    db.time  = value;
+    blk.data = &db;
+    blk.size = sizeof(db);
+
+    return M_setstat( path, Z50_BLK_DEBOUNCE, (INT32_OR_64)&blk );
+}
+
+/********************************* getDebounce *****************************/
+/** Get debouncer
+ *
+ *  \param path       \IN  MDIS path
+ *  \param input      \IN  input number (ignored on D302i)
+ *  \param valueP     \OUT debounce time [50us]
+ *
+ *  \return           0 on success, -1 on error
+ */
+static int32 getDebounce( MDIS_PATH path, int input, u_int32 *valueP )
+{
+    Z50_DEBOUNCE_PB db;
+    M_SG_BLOCK      blk;
+
+    db.input = input;
+    db.time  = 0;
+    blk.data = &db;
+    blk.size = sizeof(db);
+
+    if( M_getstat( path, Z50_BLK_DEBOUNCE, (int32*)&blk ) < 0 )
+        return -1;
+
+    *valueP = db.time;
+    return 0;
+}
@@ -67,11 +67,14 @@ static const char IdentString[]=MENT_XSTR(MAK_REVISION);
  }
 
 #define MAX_INP         16        /* number of inputs to check */
+#define SMP_PERIOD      1         /* input sample period [ms] */
+#define SMP_RECS        256       /* samples read per M_getblock */
 
 /*--------------------------------------+
 |   GLOBALS                             |
 +--------------------------------------*/
 static int G_verbose = 0;
+static u_int8 G_smpBuf[sizeof(Z50_SAMPLE_HDR) + SMP_RECS*sizeof(Z50_SAMPLE)];
 
 /*--------------------------------------+
 |   PROTOTYPES                          |
@@ -198,27 +201,46 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* let the driver sample the inputs instead of polling them */
+    FAIL_UNLESS( M_setstat( path, Z50_SAMPLE_PERIOD, SMP_PERIOD ) == 0 );
+    FAIL_UNLESS( M_setstat( path, Z50_SAMPLE_FORMAT, Z50_SMP_RLE ) == 0 );
+    FAIL_UNLESS( M_setstat( path, Z50_GETBLOCK_MODE, Z50_GBM_SAMPLE ) == 0 );
+
     /* now set all outputs and watch the inputs changing one by one */
     M_write( path, 0xffffffff );
+    FAIL_UNLESS( M_setstat( path, Z50_SAMPLING, 1 ) == 0 );
     timeref = UOS_MsecTimerGet();
 
     while( (UOS_MsecTimerGet() - timeref) < 2000 ) {
-        int32 inp;
+        Z50_SAMPLE_HDR *hdr = (Z50_SAMPLE_HDR*)G_smpBuf;
+        Z50_SAMPLE     *smp;
         u_int32 time;
         char    buf[80];
 
-        FAIL_UNLESS( M_read( path, &inp ) == 0 );
-
-        if( inp != oldInp ) {
-            time = UOS_MsecTimerGet() - timeref;
-            printf( "After %4dmsec (+%3d): %s\n",
-                    time, time - oldTime,
-                    bitString( buf, inp, MAX_INP ) );
-            oldInp = inp;
-            oldTime = time;
-        }
+        UOS_Delay( 100 );
+
+        do {
+            FAIL_UNLESS( M_getblock( path, G_smpBuf, sizeof(G_smpBuf) ) >= 0 );
+
+            if( hdr->lost )
+                printf( "*** %d samples lost\n", hdr->lost );
+
+            for( n=0, smp=(Z50_SAMPLE*)(hdr+1); n<hdr->count; ++n, ++smp ) {
+                if( (int32)smp->input != oldInp ) {
+                    time = smp->seq * hdr->period;
+                    printf( "After %4dmsec (+%3d): %s\n",
+                            time, time - oldTime,
+                            bitString( buf, smp->input, MAX_INP ) );
+                    oldInp = smp->input;
+                    oldTime = time;
+                }
+            }
+        } while( hdr->pending );
     }
 
+    M_setstat( path, Z50_SAMPLING, 0 );
+    M_setstat( path, Z50_GETBLOCK_MODE, Z50_GBM_INPUT );
+
     /*--------------------+
     |  cleanup            |
     +--------------------*/
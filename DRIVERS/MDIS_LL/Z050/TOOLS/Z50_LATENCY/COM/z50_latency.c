@@ -0,0 +1,358 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z50_LATENCY                      ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z50_latency.c
+ *       \author ulrich.bogensperger@men.de
+ *
+ *        \brief Edge-to-notification round-trip latency test
+ *
+ *  Toggles one output, waits with Z50_BLK_WAIT_EDGE for the edge on the
+ *  input it is wired to and measures the time from before the output
+ *  is switched (Z50_SET_PORTS/Z50_CLR_PORTS) until the wait returns. The round trip covers the output write, the
+ *  input (and debounce) logic, the interrupt routine and the wake-up of
+ *  the waiting thread. The results are collected in a histogram and
+ *  printed with mean, standard deviation (jitter) and percentiles.
+ *
+ *  On hardware output n must be wired to input n of the same channel.
+ *  Built with Z50_SIM (see TOOLS/Z50_SIM) the simulated register window
+ *  mirrors the output into the input register, so the test runs without
+ *  wiring; the time then only covers the driver code paths.
+ *
+ *     Required: libraries: mdis_api, usr_oss
+ *     \switches Z50_SIM
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2004-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/mdis_err.h>
+#include <MEN/z50_drv.h>
+
+#ifdef Z50_SIM
+# include "z50_sim.h"
+# define ERRNO_GET()    errno
+#else
+# include <MEN/usr_oss.h>
+# define ERRNO_GET()    UOS_ErrnoGet()
+#endif
+
+#if defined(LINUX) || defined(Z50_SIM)
+# include <time.h>
+# define FINE_CLOCK
+#endif
+
+static const char IdentString[]=MENT_XSTR(MAK_REVISION);
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define LOOPS_DEFAULT   1000000     /* round trips */
+#define TIMEOUT_DEFAULT 1000        /* wait timeout [ms] */
+#define WIDTH_DEFAULT   1000        /* histogram bucket width [ns] */
+#define BUCKETS         1000        /* histogram buckets, last = overflow */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void usage(void);
+static char *optGet( int argc, char *argv[], const char *opt );
+static u_int64 timeNs( void );
+static u_int64 percentile( u_int32 permille, u_int32 count );
+static double sqrtD( double x );
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static u_int32 G_hist[BUCKETS];     /* round trips per bucket */
+static u_int32 G_width;             /* bucket width [ns] */
+
+
+/********************************* usage ***********************************/
+/**  Print program usage
+ */
+static void usage(void)
+{
+    printf("Usage: z50_latency [<opts>] <device> [<opts>]\n");
+    printf("Function: Edge-to-notification round-trip latency test\n");
+    printf("          (output <bit> wired to input <bit>)\n");
+    printf("Options:\n");
+    printf("  device       device name..................... [none]    \n");
+    printf("  -c=<chan>    channel number (0..3)........... [0]       \n");
+    printf("  -b=<bit>     output/input number (0..31)..... [0]       \n");
+    printf("  -n=<loops>   number of round trips........... [%d]\n",
+           LOOPS_DEFAULT);
+    printf("  -t=<ms>      timeout per round trip.......... [%d]\n",
+           TIMEOUT_DEFAULT);
+    printf("  -w=<ns>      histogram bucket width.......... [%d]\n",
+           WIDTH_DEFAULT);
+    printf("  -h           print histogram................. [no]      \n");
+#ifdef Z50_SIM
+    printf("Device: bioc, d302i or d302i_gip (simulated, with loopback)\n");
+#endif
+    printf("\n");
+    printf("Copyright 2004-2019, MEN Mikro Elektronik GmbH\n%s\n", IdentString);
+}
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return           success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+    MDIS_PATH  path;
+    M_SG_BLOCK blk;
+    Z50_WAIT_PB pb;
+    char      *device, *str;
+    int32     chan, i, timeout;
+    u_int32   mask, loops, n, count = 0, timeouts = 0, out = 0;
+    u_int64   t0, ns, min = (u_int64)-1, max = 0;
+    double    sum = 0, sum2 = 0, mean, stddev;
+    int       ret = 0;
+
+    /*--------------------+
+    |  get arguments      |
+    +--------------------*/
+    for (device=NULL, i=1; i<argc; i++)
+        if (*argv[i] != '-') {
+            device = argv[i];
+            break;
+        }
+
+    if (!device || optGet(argc, argv, "?")) {
+        usage();
+        return(1);
+    }
+
+    chan     = ((str = optGet(argc, argv, "c=")) ? atoi(str) : 0);
+    mask     = 1 << ((str = optGet(argc, argv, "b=")) ? atoi(str) & 31 : 0);
+    loops    = ((str = optGet(argc, argv, "n=")) ?
+                strtoul(str, NULL, 0) : LOOPS_DEFAULT);
+    timeout  = ((str = optGet(argc, argv, "t=")) ?
+                atoi(str) : TIMEOUT_DEFAULT);
+    G_width  = ((str = optGet(argc, argv, "w=")) ?
+                strtoul(str, NULL, 0) : WIDTH_DEFAULT);
+
+    if( G_width == 0 )
+        G_width = 1;
+
+    /*--------------------+
+    |  open path          |
+    +--------------------*/
+    if ((path = M_open(device)) < 0) {
+        printf("*** can't open: %s\n", M_errstring(ERRNO_GET()));
+        return(1);
+    }
+
+#ifdef Z50_SIM
+    Z50SIM_Loopback( 0xffffffff );
+#endif
+
+    /* interrupt on both edges of the input */
+    if ((M_setstat(path, M_MK_CH_CURRENT, chan)) < 0 ||
+        (M_setstat(path, Z50_CLR_PORTS, mask)) < 0 ||
+        (M_setstat(path, Z50_IRQ_EDGE_RAISE, mask)) < 0 ||
+        (M_setstat(path, Z50_IRQ_EDGE_FALL, mask)) < 0 ||
+        (M_setstat(path, M_MK_IRQ_ENABLE, 1)) < 0) {
+        printf("*** can't setstat: %s\n", M_errstring(ERRNO_GET()));
+        ret = 1;
+        goto ABORT;
+    }
+
+    /* discard edges of the initial state */
+    pb.raiseMask = pb.fallMask = mask;
+    pb.timeout   = 0;
+    blk.data     = &pb;
+    blk.size     = sizeof(pb);
+    M_getstat(path, Z50_BLK_WAIT_EDGE, (int32*)&blk);
+
+    /*--------------------+
+    |  round trips        |
+    +--------------------*/
+    for( n=0; n<loops; n++ ) {
+        out ^= mask;
+        pb.raiseMask = out & mask;
+        pb.fallMask  = ~out & mask;
+        pb.timeout   = timeout;
+
+        t0 = timeNs();
+
+        if( M_setstat(path, (out & mask) ? Z50_SET_PORTS : Z50_CLR_PORTS,
+                      mask) < 0 ) {
+            printf("*** can't set output: %s\n", M_errstring(ERRNO_GET()));
+            ret = 1;
+            break;
+        }
+
+        if( M_getstat(path, Z50_BLK_WAIT_EDGE, (int32*)&blk) < 0 ) {
+            if( ERRNO_GET() != ERR_OSS_TIMEOUT ) {
+                printf("*** can't wait: %s\n", M_errstring(ERRNO_GET()));
+                ret = 1;
+                break;
+            }
+            timeouts++;
+            continue;
+        }
+
+        ns = timeNs() - t0;
+
+        if( ns < min ) min = ns;
+        if( ns > max ) max = ns;
+        sum  += (double)ns;
+        sum2 += (double)ns * (double)ns;
+        count++;
+
+        G_hist[ns / G_width < BUCKETS-1 ? ns / G_width : BUCKETS-1]++;
+    }
+
+    /*--------------------+
+    |  print results      |
+    +--------------------*/
+    mean   = count ? sum / count : 0;
+    stddev = count ? sqrtD( sum2 / count - mean * mean ) : 0;
+
+    printf("loops,timeouts,min_ns,mean_ns,stddev_ns,p50_ns,p99_ns,"
+           "p999_ns,max_ns\n");
+    printf("%u,%u,%llu,%.0f,%.0f,%llu,%llu,%llu,%llu\n",
+           count, timeouts,
+           count ? (unsigned long long)min : 0ULL, mean, stddev,
+           (unsigned long long)percentile( 500, count ),
+           (unsigned long long)percentile( 990, count ),
+           (unsigned long long)percentile( 999, count ),
+           (unsigned long long)max);
+
+    if( optGet(argc, argv, "h") ) {
+        printf("bucket_ns,count\n");
+        for( n=0; n<BUCKETS; n++ )
+            if( G_hist[n] )
+                printf("%s%llu,%u\n", n == BUCKETS-1 ? ">=" : "",
+                       (unsigned long long)n * G_width, G_hist[n]);
+    }
+
+    /*--------------------+
+    |  cleanup            |
+    +--------------------*/
+    M_setstat(path, M_MK_IRQ_ENABLE, 0);
+    M_setstat(path, Z50_CLR_PORTS, mask);
+
+ABORT:
+    if (M_close(path) < 0) {
+        printf("*** can't close: %s\n", M_errstring(ERRNO_GET()));
+        ret = 1;
+    }
+
+    return(ret);
+}
+
+/********************************* optGet **********************************/
+/** Find option "-<opt>" in argument list
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *  \param opt        \IN  option, e.g. "c=" or "?"
+ *
+ *  \return           value after "=", "" for flags, NULL if not given
+ */
+static char *optGet( int argc, char *argv[], const char *opt )
+{
+    size_t len = strlen( opt );
+    int i;
+
+    for( i=1; i<argc; i++ )
+        if( argv[i][0] == '-' && !strncmp( argv[i]+1, opt, len ) )
+            return argv[i] + 1 + len;
+
+    return NULL;
+}
+
+/********************************* timeNs **********************************/
+/** Get timestamp
+ *
+ *  \return           time [ns]
+ */
+static u_int64 timeNs( void )
+{
+#ifdef FINE_CLOCK
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (u_int64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return (u_int64)UOS_MsecTimerGet() * 1000000;
+#endif
+}
+
+/********************************* percentile ******************************/
+/** Get percentile from histogram
+ *
+ *  \param permille   \IN  percentile [1/1000]
+ *  \param count      \IN  number of values in histogram
+ *
+ *  \return           upper bound of the bucket holding the percentile [ns]
+ */
+static u_int64 percentile( u_int32 permille, u_int32 count )
+{
+    u_int64 need = ((u_int64)count * permille + 999) / 1000, sum = 0;
+    u_int32 n;
+
+    if( count == 0 )
+        return 0;
+
+    for( n=0; n<BUCKETS; n++ ) {
+        sum += G_hist[n];
+        if( sum >= need )
+            break;
+    }
+    return (u_int64)(n + 1) * G_width;
+}
+
+/********************************* sqrtD ***********************************/
+/** Square root (Newton iteration, avoids linking the math library)
+ *
+ *  \param x          \IN  value
+ *
+ *  \return           square root of x, 0 for x <= 0
+ */
+static double sqrtD( double x )
+{
+    double r = x;
+    int i;
+
+    if( x <= 0 )
+        return 0;
+
+    for( i=0; i<64; i++ )
+        r = (r + x / r) / 2;
+
+    return r;
+}
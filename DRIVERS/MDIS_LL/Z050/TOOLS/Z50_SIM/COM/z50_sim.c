@@ -0,0 +1,1501 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z50_sim.c
+ *
+ *      \author  ulrich.bogensperger@men.de
+ *
+ *      \brief Register-level simulator backend for the Z50 low-level driver
+ *
+ *  The module replaces hardware, OSS, DESC and the MDIS kernel for a
+ *  host build of z50_drv.c (compiled with Z50_SIM):
+ *
+ *  - a model of the BIOC and D302i register windows: raw and debounced
+ *    inputs, outputs, write-1-to-clear edge latches, interrupt masks,
+ *    debounce registers (50us units) and the D302i GIEN/GIP bits; the
+ *    window has the size requested by the driver
+ *  - a virtual clock in nanoseconds, advanced only by Z50SIM_Run() and
+ *    by blocking semaphore waits of the driver
+ *  - a stimulus queue for input changes (steps, contact bounce, clocks)
+ *    and an optional loopback from outputs to inputs
+ *  - OSS alarms, semaphores and signals running on the virtual clock
+ *  - an interrupt line which calls the driver's Irq entry as long as an
+ *    enabled edge is latched, plus an injector for foreign interrupts
+ *  - the MDIS user API (M_open() ...) calling the driver's jump table
+ *    with the same channel and semaphore handling as the MDIS kernel
+ *
+ *  Everything is single threaded; the driver's Irq and alarm entries
+ *  are only called outside of driver calls or while the driver waits
+ *  on a semaphore, as an interrupt would do on the target.
+ *
+ *     Required: MDIS headers (men_typs.h, oss.h, desc.h, mdis_api.h, ...)
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2004-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _NO_LL_HANDLE       /* ll_defs.h: don't define LL_HANDLE struct */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <MEN/men_typs.h>   /* system dependent definitions   */
+#include "z50_sim.h"        /* simulated register window      */
+#include <MEN/oss.h>        /* oss functions                  */
+#include <MEN/desc.h>       /* descriptor functions           */
+#include <MEN/mdis_api.h>   /* MDIS global defs               */
+#include <MEN/mdis_err.h>   /* MDIS error codes               */
+#include <MEN/ll_defs.h>    /* low-level driver definitions   */
+
+typedef void LL_HANDLE;     /* opaque for the simulator */
+
+#include <MEN/ll_entry.h>   /* low-level driver jump table  */
+
+#include "d302i.h"          /* register definitions for D302 Infineon */
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define SIM_CH          4           /**< max. register sets */
+#define SIM_IN          32          /**< inputs per register set */
+#define SIM_PATHS       8           /**< max. open paths */
+#define SIM_KEYS        32          /**< max. descriptor keys */
+#define SIM_KEYLEN      32          /**< max. length of descriptor key */
+#define SIM_IRQ_LOOPS   16          /**< Irq calls per pending interrupt */
+#define SIM_NONE        ((u_int64)-1)   /**< no event scheduled */
+
+/* BIOC register window */
+#define BIOC_INPUT          0x00
+#define BIOC_OUTPUT         0x04
+#define BIOC_EDGE_RAISE     0x08
+#define BIOC_EDGE_FALL      0x0c
+#define BIOC_IRQ_EDGE_RAISE 0x10
+#define BIOC_IRQ_EDGE_FALL  0x14
+#define BIOC_CONTROL        0x20
+#define BIOC_DEBOUNCE       0x80
+#define BIOC_SIZE           0x100
+#define D302I_SIZE          (D302I_CTRL+4)
+
+#define MS_NS(ms)       ((u_int64)(ms) * 1000000)   /**< ms -> ns */
+#define US_NS(us)       ((u_int64)(us) * 1000)      /**< us -> ns */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** register window */
+struct Z50SIM_DEV {
+    int     d302i;                  /**< D302i layout, else BIOC */
+    u_int32 size;                   /**< size of window */
+    u_int32 numCh;                  /**< register sets */
+    u_int32 raw[SIM_CH];            /**< input pins */
+    u_int32 input[SIM_CH];          /**< debounced inputs */
+    u_int32 output[SIM_CH];         /**< output registers */
+    u_int32 edgeRaise[SIM_CH];      /**< edge latches */
+    u_int32 edgeFall[SIM_CH];
+    u_int32 irqRaise[SIM_CH];       /**< irq masks */
+    u_int32 irqFall[SIM_CH];
+    u_int32 debounce[SIM_IN];       /**< debounce registers */
+    u_int32 ctrl;                   /**< D302i control register */
+    u_int32 dbMask[SIM_CH];         /**< inputs with pending change */
+    u_int64 dbDue[SIM_CH][SIM_IN];  /**< time pin is stable */
+};
+
+/** scheduled input change */
+typedef struct {
+    u_int64 t;                      /**< time [ns] */
+    u_int32 ch;                     /**< register set */
+    u_int32 mask;                   /**< affected inputs */
+    u_int32 value;                  /**< new state */
+} SIM_STIM;
+
+/** OSS alarm */
+typedef struct SIM_ALARM {
+    void    (*fct)(void *arg);      /**< handler */
+    void    *arg;                   /**< handler argument */
+    int     active;                 /**< armed */
+    int     cyclic;                 /**< re-arm after expiry */
+    u_int64 period;                 /**< [ns] */
+    u_int64 next;                   /**< expiry [ns] */
+    struct SIM_ALARM *link;         /**< next alarm */
+} SIM_ALARM;
+
+/** OSS semaphore */
+typedef struct {
+    int32   type;                   /**< OSS_SEM_BIN/COUNT */
+    int32   count;                  /**< tokens */
+} SIM_SEM;
+
+/** OSS signal */
+typedef struct {
+    int32   signal;                 /**< signal number */
+} SIM_SIG;
+
+/** OSS spin lock */
+typedef struct {
+    int     held;                   /**< acquired */
+} SIM_SPINL;
+
+/** descriptor key */
+typedef struct {
+    char    key[SIM_KEYLEN];        /**< key name */
+    u_int32 value;                  /**< value */
+} SIM_KEY;
+
+/** simulator state */
+typedef struct {
+    struct Z50SIM_DEV dev;          /**< register window */
+    u_int64   now;                  /**< virtual clock [ns] */
+    u_int32   cost;                 /**< [ns] per register access */
+    u_int32   almRes;               /**< [ms] alarm resolution, 0=1ms */
+    u_int32   tsRate;               /**< timestamp rate, 0=1MHz */
+    u_int32   loopMask;             /**< inputs following outputs */
+    SIM_STIM  *stim;                /**< stimulus queue, sorted */
+    u_int32   stimCnt;              /**< queued entries */
+    u_int32   stimMax;              /**< allocated entries */
+    SIM_ALARM *alarms;              /**< created alarms */
+    u_int32   maskDepth;            /**< OSS_IrqMaskR() nesting */
+    SIM_KEY   key[SIM_KEYS];        /**< descriptor */
+    u_int32   keyCnt;               /**< used descriptor keys */
+    LL_ENTRY  entry;                /**< driver's jump table */
+    LL_HANDLE *llHdl;               /**< driver handle, NULL if closed */
+    OSS_SEM_HANDLE *devSem;         /**< device semaphore */
+    int       irqEnable;            /**< M_MK_IRQ_ENABLE */
+    int       inIrq;                /**< Irq entry running */
+    int32     pathCh[SIM_PATHS];    /**< current channel, -1 = free */
+    u_int32   pathCnt;              /**< open paths */
+    Z50SIM_COUNTERS cnt;            /**< counters */
+} SIM;
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+static SIM G_sim;
+static int G_init;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern void LL_GetEntry( LL_ENTRY* drvP );  /* driver built with
+                                               _ONE_NAMESPACE_PER_DRIVER_ */
+
+static void    simInit( void );
+static void    simReset( struct Z50SIM_DEV *dev );
+static u_int32 dbTime( struct Z50SIM_DEV *dev, u_int32 ch, u_int32 in );
+static void    pinSet( u_int32 ch, u_int32 mask, u_int32 value );
+static void    dbUpdate( void );
+static int     irqPending( void );
+static void    irqDeliver( void );
+static u_int64 nextEvent( void );
+static void    step( u_int64 t );
+static int32   stimAdd( u_int64 t, u_int32 ch, u_int32 mask, u_int32 value );
+static int32   pathCh( MDIS_PATH path );
+static int32   apiDone( int32 error );
+static int     isBlkCode( int32 code );
+
+
+/******************************** simInit ***********************************/
+/** Initialize simulator state once
+ */
+static void simInit( void )
+{
+    int i;
+
+    if( G_init )
+        return;
+
+    memset( &G_sim, 0, sizeof(G_sim) );
+    for( i=0; i<SIM_PATHS; i++ )
+        G_sim.pathCh[i] = -1;
+
+    simReset( &G_sim.dev );
+    G_init = 1;
+}
+
+/******************************** simReset **********************************/
+/** Reset register window to power-up state (keeps input pins)
+ *
+ *  \param dev      \IN  register window
+ */
+static void simReset( struct Z50SIM_DEV *dev )
+{
+    u_int32 ch;
+
+    dev->size  = dev->d302i ? D302I_SIZE : BIOC_SIZE;
+    dev->numCh = dev->d302i ? SIM_CH : 1;
+    dev->ctrl  = D302I_CTRL_GIEN;
+
+    for( ch=0; ch<SIM_CH; ch++ ){
+        dev->input[ch]     = dev->raw[ch];
+        dev->output[ch]    = 0;
+        dev->edgeRaise[ch] = dev->edgeFall[ch] = 0;
+        dev->irqRaise[ch]  = dev->irqFall[ch]  = 0;
+        dev->dbMask[ch]    = 0;
+    }
+    memset( dev->debounce, 0, sizeof(dev->debounce) );
+}
+
+/******************************** dbTime ************************************/
+/** Get debounce time of input
+ *
+ *  \param dev      \IN  register window
+ *  \param ch       \IN  register set
+ *  \param in       \IN  input number
+ *
+ *  \return         debounce time [ns]
+ */
+static u_int32 dbTime( struct Z50SIM_DEV *dev, u_int32 ch, u_int32 in )
+{
+    u_int32 units;
+
+    if( dev->d302i )
+        units = dev->debounce[ch];      /* one register per channel */
+    else
+        units = dev->debounce[in];      /* one register per input */
+
+    return units * Z50SIM_DEBOUNCE_NS;
+}
+
+/******************************** pinSet ************************************/
+/** Change input pins and start debouncing of changed inputs
+ *
+ *  \param ch       \IN  register set
+ *  \param mask     \IN  affected inputs
+ *  \param value    \IN  new state
+ */
+static void pinSet( u_int32 ch, u_int32 mask, u_int32 value )
+{
+    struct Z50SIM_DEV *dev = &G_sim.dev;
+    u_int32 raw, chg, in;
+
+    raw = (dev->raw[ch] & ~mask) | (value & mask);
+    chg = raw ^ dev->raw[ch];
+    dev->raw[ch] = raw;
+
+    for( in=0; chg; in++, chg >>= 1 ){
+        if( chg & 1 ){
+            dev->dbDue[ch][in] = G_sim.now + dbTime( dev, ch, in );
+            dev->dbMask[ch] |= (u_int32)1 << in;
+        }
+    }
+    dbUpdate();
+}
+
+/******************************** dbUpdate **********************************/
+/** Apply pin changes which were stable for the debounce time
+ *
+ *  An input changes its state, and latches the edge, when the pin had
+ *  the new state for the complete debounce time. Shorter pulses are
+ *  suppressed.
+ */
+static void dbUpdate( void )
+{
+    struct Z50SIM_DEV *dev = &G_sim.dev;
+    u_int32 ch, in, bit;
+
+    for( ch=0; ch<SIM_CH; ch++ ){
+        for( in=0; in<SIM_IN && (dev->dbMask[ch] >> in); in++ ){
+            bit = (u_int32)1 << in;
+            if( !(dev->dbMask[ch] & bit) || dev->dbDue[ch][in] > G_sim.now )
+                continue;
+
+            dev->dbMask[ch] &= ~bit;
+            if( (dev->raw[ch] ^ dev->input[ch]) & bit ){
+                dev->input[ch] ^= bit;
+                if( dev->input[ch] & bit )
+                    dev->edgeRaise[ch] |= bit;
+                else
+                    dev->edgeFall[ch] |= bit;
+            }
+        }
+    }
+}
+
+/******************************** irqPending ********************************/
+/** Check state of interrupt line
+ *
+ *  \return         1 if an enabled edge is latched
+ */
+static int irqPending( void )
+{
+    struct Z50SIM_DEV *dev = &G_sim.dev;
+    u_int32 ch;
+
+    if( dev->d302i && !(dev->ctrl & D302I_CTRL_GIEN) )
+        return 0;
+
+    for( ch=0; ch<dev->numCh; ch++ ){
+        if( (dev->edgeRaise[ch] & dev->irqRaise[ch]) ||
+            (dev->edgeFall[ch] & dev->irqFall[ch]) )
+            return 1;
+    }
+    return 0;
+}
+
+/******************************** irqDeliver ********************************/
+/** Call driver's Irq entry while the interrupt line is active
+ *
+ *  Like a level triggered line, the entry is called again when the
+ *  interrupt is still pending after return. After SIM_IRQ_LOOPS calls
+ *  the interrupt is counted as stuck and delivery is retried on the
+ *  next simulation step.
+ */
+static void irqDeliver( void )
+{
+    int n;
+
+    if( !G_sim.llHdl || !G_sim.irqEnable || G_sim.maskDepth || G_sim.inIrq )
+        return;
+
+    for( n=0; n<SIM_IRQ_LOOPS && irqPending(); n++ )
+        Z50SIM_IrqInject();
+
+    if( n == SIM_IRQ_LOOPS && irqPending() )
+        G_sim.cnt.irqStuck++;
+}
+
+/******************************** nextEvent *********************************/
+/** Get time of next scheduled event
+ *
+ *  \return         time [ns] or SIM_NONE
+ */
+static u_int64 nextEvent( void )
+{
+    struct Z50SIM_DEV *dev = &G_sim.dev;
+    u_int64 t = SIM_NONE;
+    SIM_ALARM *alm;
+    u_int32 ch, in;
+
+    if( G_sim.stimCnt )
+        t = G_sim.stim[0].t;
+
+    for( alm=G_sim.alarms; alm; alm=alm->link )
+        if( alm->active && alm->next < t )
+            t = alm->next;
+
+    for( ch=0; ch<SIM_CH; ch++ )
+        for( in=0; in<SIM_IN && (dev->dbMask[ch] >> in); in++ )
+            if( (dev->dbMask[ch] & ((u_int32)1 << in)) &&
+                dev->dbDue[ch][in] < t )
+                t = dev->dbDue[ch][in];
+
+    return t;
+}
+
+/******************************** step **************************************/
+/** Advance virtual clock and process all events due
+ *
+ *  \param t        \IN  new time [ns], ignored when in the past
+ */
+static void step( u_int64 t )
+{
+    SIM_ALARM *alm;
+
+    if( t > G_sim.now )
+        G_sim.now = t;
+
+    /* input stimulus */
+    while( G_sim.stimCnt && G_sim.stim[0].t <= G_sim.now ){
+        SIM_STIM s = G_sim.stim[0];
+
+        G_sim.stimCnt--;
+        memmove( &G_sim.stim[0], &G_sim.stim[1],
+                 G_sim.stimCnt * sizeof(SIM_STIM) );
+        pinSet( s.ch, s.mask, s.value );
+    }
+    dbUpdate();
+    irqDeliver();
+
+    /* driver timer */
+    for( alm=G_sim.alarms; alm; alm=alm->link ){
+        if( !alm->active || alm->next > G_sim.now )
+            continue;
+
+        if( alm->cyclic )
+            alm->next += alm->period;
+        else
+            alm->active = 0;
+
+        G_sim.cnt.alarmCall++;
+        G_sim.inIrq++;
+        alm->fct( alm->arg );
+        G_sim.inIrq--;
+        irqDeliver();
+    }
+}
+
+/******************************** stimAdd ***********************************/
+/** Queue input change
+ *
+ *  \param t        \IN  time [ns]
+ *  \param ch       \IN  register set
+ *  \param mask     \IN  affected inputs
+ *  \param value    \IN  new state
+ *
+ *  \return         \c 0 on success or error code
+ */
+static int32 stimAdd( u_int64 t, u_int32 ch, u_int32 mask, u_int32 value )
+{
+    u_int32 i;
+
+    if( ch >= SIM_CH )
+        return ERR_LL_ILL_CHAN;
+
+    if( G_sim.stimCnt == G_sim.stimMax ){
+        u_int32 max = G_sim.stimMax ? 2 * G_sim.stimMax : 256;
+        SIM_STIM *p = realloc( G_sim.stim, max * sizeof(SIM_STIM) );
+
+        if( !p )
+            return ERR_OSS_MEM_ALLOC;
+        G_sim.stim    = p;
+        G_sim.stimMax = max;
+    }
+
+    /* keep order of entries with same time */
+    for( i=G_sim.stimCnt; i && G_sim.stim[i-1].t > t; i-- )
+        ;
+    memmove( &G_sim.stim[i+1], &G_sim.stim[i],
+             (G_sim.stimCnt - i) * sizeof(SIM_STIM) );
+    G_sim.stim[i].t     = t;
+    G_sim.stim[i].ch    = ch;
+    G_sim.stim[i].mask  = mask;
+    G_sim.stim[i].value = value;
+    G_sim.stimCnt++;
+
+    return ERR_SUCCESS;
+}
+
+/*==========================================================================+
+|  register window                                                          |
++==========================================================================*/
+
+/******************************** Z50SIM_Read *******************************/
+/** Read register
+ *
+ *  \param ma       \IN  register window
+ *  \param offs     \IN  register offset
+ *
+ *  \return         register value
+ */
+u_int32 Z50SIM_Read( MACCESS ma, u_int32 offs )
+{
+    struct Z50SIM_DEV *dev = ma;
+    u_int32 n = (offs >> 2) & 3;
+
+    if( (offs & 3) || offs >= dev->size ){
+        fprintf(stderr, "*** z50_sim: read outside window: 0x%x\n", offs);
+        abort();
+    }
+    G_sim.cnt.regRead++;
+    G_sim.now += G_sim.cost;
+
+    if( dev->d302i ){
+        if( offs == D302I_CTRL )
+            return dev->ctrl | (irqPending() ? D302I_CTRL_GIP : 0);
+
+        switch( offs & ~0xf ){
+        case D302I_INPUT(0):            return dev->input[n];
+        case D302I_OUTPUT(0):           return dev->output[n];
+        case D302I_EDGE_RAISE(0):       return dev->edgeRaise[n];
+        case D302I_EDGE_FALL(0):        return dev->edgeFall[n];
+        case D302I_IRQ_EDGE_RAISE(0):   return dev->irqRaise[n];
+        case D302I_IRQ_EDGE_FALL(0):    return dev->irqFall[n];
+        case D302I_DEBOUNCE(0):         return dev->debounce[n];
+        }
+        return 0;
+    }
+
+    if( offs >= BIOC_DEBOUNCE )
+        return dev->debounce[(offs - BIOC_DEBOUNCE) >> 2];
+
+    switch( offs ){
+    case BIOC_INPUT:            return dev->input[0];
+    case BIOC_OUTPUT:           return dev->output[0];
+    case BIOC_EDGE_RAISE:       return dev->edgeRaise[0];
+    case BIOC_EDGE_FALL:        return dev->edgeFall[0];
+    case BIOC_IRQ_EDGE_RAISE:   return dev->irqRaise[0];
+    case BIOC_IRQ_EDGE_FALL:    return dev->irqFall[0];
+    }
+    return 0;
+}
+
+/******************************** Z50SIM_Write ******************************/
+/** Write register
+ *
+ *  Edge registers are write-1-to-clear. Writing 1 to the BIOC control
+ *  register resets the edge and debounce logic.
+ *
+ *  \param ma       \IN  register window
+ *  \param offs     \IN  register offset
+ *  \param val      \IN  value to write
+ */
+void Z50SIM_Write( MACCESS ma, u_int32 offs, u_int32 val )
+{
+    struct Z50SIM_DEV *dev = ma;
+    u_int32 n = (offs >> 2) & 3;
+    u_int32 reg;
+
+    if( (offs & 3) || offs >= dev->size ){
+        fprintf(stderr, "*** z50_sim: write outside window: 0x%x\n", offs);
+        abort();
+    }
+    G_sim.cnt.regWrite++;
+    G_sim.now += G_sim.cost;
+
+    /* map BIOC offsets to D302i register groups */
+    if( dev->d302i ){
+        if( offs == D302I_CTRL ){
+            dev->ctrl = val & D302I_CTRL_GIEN;
+            return;
+        }
+        reg = offs & ~0xf;
+    }
+    else {
+        n = 0;
+        if( offs >= BIOC_DEBOUNCE ){
+            n   = (offs - BIOC_DEBOUNCE) >> 2;
+            reg = D302I_DEBOUNCE(0);
+        }
+        else switch( offs ){
+        case BIOC_OUTPUT:           reg = D302I_OUTPUT(0);          break;
+        case BIOC_EDGE_RAISE:       reg = D302I_EDGE_RAISE(0);      break;
+        case BIOC_EDGE_FALL:        reg = D302I_EDGE_FALL(0);       break;
+        case BIOC_IRQ_EDGE_RAISE:   reg = D302I_IRQ_EDGE_RAISE(0);  break;
+        case BIOC_IRQ_EDGE_FALL:    reg = D302I_IRQ_EDGE_FALL(0);   break;
+        case BIOC_CONTROL:
+            if( val & 1 ){
+                for( n=0; n<SIM_CH; n++ ){
+                    dev->edgeRaise[n] = dev->edgeFall[n] = 0;
+                    dev->dbMask[n] = 0;
+                    dev->input[n]  = dev->raw[n];
+                }
+            }
+            return;
+        default:
+            return;
+        }
+    }
+
+    switch( reg ){
+    case D302I_OUTPUT(0):
+        dev->output[n] = val;
+        if( G_sim.loopMask )
+            pinSet( n, G_sim.loopMask, val );
+        break;
+    case D302I_EDGE_RAISE(0):       dev->edgeRaise[n] &= ~val;  break;
+    case D302I_EDGE_FALL(0):        dev->edgeFall[n]  &= ~val;  break;
+    case D302I_IRQ_EDGE_RAISE(0):   dev->irqRaise[n]  = val;    break;
+    case D302I_IRQ_EDGE_FALL(0):    dev->irqFall[n]   = val;    break;
+    case D302I_DEBOUNCE(0):         dev->debounce[n]  = val;    break;
+    }
+}
+
+/*==========================================================================+
+|  simulator control                                                        |
++==========================================================================*/
+
+/******************************** Z50SIM_Config *****************************/
+/** Select simulated hardware
+ *
+ *  Sets the descriptor keys Z50_D302I and Z50_D302I_GIP. Must be called
+ *  before the device is opened.
+ *
+ *  \param d302i    \IN  1=D302i layout, 0=BIOC layout
+ *  \param gip      \IN  1=driver uses GIP/GIEN of D302i
+ */
+void Z50SIM_Config( int d302i, int gip )
+{
+    simInit();
+
+    G_sim.dev.d302i = d302i;
+    simReset( &G_sim.dev );
+
+    Z50SIM_DescSet( "Z50_D302I", d302i );
+    Z50SIM_DescSet( "Z50_D302I_GIP", gip );
+}
+
+/******************************** Z50SIM_DescSet ****************************/
+/** Set descriptor key used when the device is opened
+ *
+ *  \param key      \IN  key name
+ *  \param value    \IN  value
+ *
+ *  \return         \c 0 on success or error code
+ */
+int32 Z50SIM_DescSet( const char *key, u_int32 value )
+{
+    u_int32 i;
+
+    simInit();
+
+    for( i=0; i<G_sim.keyCnt; i++ )
+        if( !strcmp( G_sim.key[i].key, key ) )
+            break;
+
+    if( i == SIM_KEYS || strlen(key) >= SIM_KEYLEN )
+        return ERR_OSS_ILL_PARAM;
+
+    if( i == G_sim.keyCnt ){
+        strcpy( G_sim.key[i].key, key );
+        G_sim.keyCnt++;
+    }
+    G_sim.key[i].value = value;
+
+    return ERR_SUCCESS;
+}
+
+/******************************** Z50SIM_AccessCost *************************/
+/** Set time charged for each register access
+ *
+ *  Lets the virtual clock reflect bus access time, so timestamps taken
+ *  by the driver show the duration of register-heavy code paths.
+ *
+ *  \param nsec     \IN  time per access [ns], 0=none (default)
+ */
+void Z50SIM_AccessCost( u_int32 nsec )
+{
+    simInit();
+    G_sim.cost = nsec;
+}
+
+/******************************** Z50SIM_AlarmRes ***************************/
+/** Set resolution of OSS alarms
+ *
+ *  Alarm periods are rounded up to a multiple of it, like an OS does
+ *  with its system tick (e.g. 4 ms at HZ=250).
+ *
+ *  \param msec     \IN  resolution [ms], 0 or 1=exact (default)
+ */
+void Z50SIM_AlarmRes( u_int32 msec )
+{
+    simInit();
+    G_sim.almRes = msec;
+}
+
+/******************************** Z50SIM_TsRate *****************************/
+/** Set rate of the driver timestamps
+ *
+ *  Lets the driver see a coarse clock, e.g. 250 for the OSS tick of a
+ *  HZ=250 system.
+ *
+ *  \param rate     \IN  timestamp ticks per second, 0=1000000 (default)
+ */
+void Z50SIM_TsRate( u_int32 rate )
+{
+    simInit();
+    G_sim.tsRate = rate;
+}
+
+/******************************** Z50SIM_TsGet ******************************/
+/** Get driver timestamp (Z50_TIMESTAMP)
+ *
+ *  \return         virtual time [timestamp ticks]
+ */
+u_int32 Z50SIM_TsGet( void )
+{
+    return (u_int32)(G_sim.now / 1000 * Z50SIM_TsRateGet() / 1000000);
+}
+
+/******************************** Z50SIM_TsRateGet **************************/
+/** Get rate of driver timestamps (Z50_TIMESTAMP_RATE)
+ *
+ *  \return         timestamp ticks per second
+ */
+u_int32 Z50SIM_TsRateGet( void )
+{
+    return G_sim.tsRate ? G_sim.tsRate : 1000000;
+}
+
+/******************************** Z50SIM_TimeUs *****************************/
+/** Get virtual time
+ *
+ *  \return         time since start [us]
+ */
+u_int32 Z50SIM_TimeUs( void )
+{
+    return (u_int32)(G_sim.now / 1000);
+}
+
+/******************************** Z50SIM_Run ********************************/
+/** Advance virtual time, processing stimulus, alarms and interrupts
+ *
+ *  \param usec     \IN  time to run [us]
+ */
+void Z50SIM_Run( u_int32 usec )
+{
+    u_int64 end, t;
+
+    simInit();
+    end = G_sim.now + US_NS(usec);
+
+    irqDeliver();
+    while( (t = nextEvent()) <= end )
+        step( t );
+
+    if( end > G_sim.now )
+        G_sim.now = end;
+}
+
+/******************************** Z50SIM_Input ******************************/
+/** Change input pins now
+ *
+ *  \param ch       \IN  register set
+ *  \param mask     \IN  affected inputs
+ *  \param value    \IN  new state
+ */
+void Z50SIM_Input( u_int32 ch, u_int32 mask, u_int32 value )
+{
+    simInit();
+
+    if( ch < SIM_CH ){
+        pinSet( ch, mask, value );
+        irqDeliver();
+    }
+}
+
+/******************************** Z50SIM_Stim *******************************/
+/** Schedule change of input pins
+ *
+ *  \param delay    \IN  time from now [us]
+ *  \param ch       \IN  register set
+ *  \param mask     \IN  affected inputs
+ *  \param value    \IN  new state
+ *
+ *  \return         \c 0 on success or error code
+ */
+int32 Z50SIM_Stim( u_int32 delay, u_int32 ch, u_int32 mask, u_int32 value )
+{
+    simInit();
+    return stimAdd( G_sim.now + US_NS(delay), ch, mask, value );
+}
+
+/******************************** Z50SIM_Bounce *****************************/
+/** Schedule bouncing contact
+ *
+ *  The inputs go to \a value, bounce back \a count times and settle on
+ *  \a value after 2*count intervals.
+ *
+ *  \param ch       \IN  register set
+ *  \param mask     \IN  affected inputs
+ *  \param value    \IN  final state
+ *  \param count    \IN  number of bounces
+ *  \param interval \IN  time between pin changes [us]
+ *
+ *  \return         \c 0 on success or error code
+ */
+int32 Z50SIM_Bounce( u_int32 ch, u_int32 mask, u_int32 value,
+                     u_int32 count, u_int32 interval )
+{
+    int32 error = ERR_SUCCESS;
+    u_int32 i;
+
+    simInit();
+
+    for( i=0; i<=2*count && !error; i++ )
+        error = stimAdd( G_sim.now + US_NS(i) * interval, ch, mask,
+                         (i & 1) ? ~value : value );
+    return error;
+}
+
+/******************************** Z50SIM_Clock ******************************/
+/** Schedule square wave
+ *
+ *  \param ch       \IN  register set
+ *  \param mask     \IN  affected inputs
+ *  \param half     \IN  half period [us]
+ *  \param count    \IN  number of periods, starting with high level
+ *
+ *  \return         \c 0 on success or error code
+ */
+int32 Z50SIM_Clock( u_int32 ch, u_int32 mask, u_int32 half, u_int32 count )
+{
+    int32 error = ERR_SUCCESS;
+    u_int32 i;
+
+    simInit();
+
+    for( i=0; i<2*count && !error; i++ )
+        error = stimAdd( G_sim.now + US_NS(i) * half, ch, mask,
+                         (i & 1) ? 0 : mask );
+    return error;
+}
+
+/******************************** Z50SIM_Loopback ***************************/
+/** Connect outputs to inputs of the same register set
+ *
+ *  \param mask     \IN  connected bits, 0=none
+ */
+void Z50SIM_Loopback( u_int32 mask )
+{
+    u_int32 ch;
+
+    simInit();
+    G_sim.loopMask = mask;
+
+    for( ch=0; ch<SIM_CH; ch++ )
+        pinSet( ch, mask, G_sim.dev.output[ch] );
+    irqDeliver();
+}
+
+/******************************** Z50SIM_Output *****************************/
+/** Get state of output register
+ *
+ *  \param ch       \IN  register set
+ *
+ *  \return         output register
+ */
+u_int32 Z50SIM_Output( u_int32 ch )
+{
+    return ch < SIM_CH ? G_sim.dev.output[ch] : 0;
+}
+
+/******************************** Z50SIM_Map ********************************/
+/** Get image of the register window for the z50_map.h accessors
+ *
+ *  Stands in for a user mapping of the hardware: the input and output
+ *  registers are copied at the time of the call, in the little endian
+ *  byte order of the hardware. All other registers read as 0. No
+ *  register access is counted.
+ *
+ *  \return         register window image (valid until the next call)
+ */
+u_int32 *Z50SIM_Map( void )
+{
+    static u_int32 win[D302I_SIZE/4];
+    struct Z50SIM_DEV *dev = &G_sim.dev;
+    u_int32 ch, i;
+
+    memset( win, 0, sizeof(win) );
+
+    for( ch=0; ch<dev->numCh; ch++ ) {
+        u_int8 *in  = (u_int8*)&win[(dev->d302i ? D302I_INPUT(ch) :
+                                     BIOC_INPUT) / 4];
+        u_int8 *out = (u_int8*)&win[(dev->d302i ? D302I_OUTPUT(ch) :
+                                     BIOC_OUTPUT) / 4];
+
+        for( i=0; i<4; i++ ) {
+            in[i]  = (u_int8)(dev->input[ch] >> (8*i));
+            out[i] = (u_int8)(dev->output[ch] >> (8*i));
+        }
+    }
+    return win;
+}
+
+/******************************** Z50SIM_IrqInject **************************/
+/** Call driver's Irq entry once
+ *
+ *  Without a latched edge this simulates an interrupt of another device
+ *  on a shared line.
+ *
+ *  \return         return value of Irq entry or -1 if device not open
+ */
+int32 Z50SIM_IrqInject( void )
+{
+    int32 ret;
+
+    if( !G_sim.llHdl )
+        return -1;
+
+    G_sim.cnt.irqCall++;
+    G_sim.inIrq++;
+    ret = G_sim.entry.irq( G_sim.llHdl );
+    G_sim.inIrq--;
+
+    if( ret == LL_IRQ_DEVICE )
+        G_sim.cnt.irqOwn++;
+
+    return ret;
+}
+
+/******************************** Z50SIM_Counters ***************************/
+/** Get (and reset) simulator counters
+ *
+ *  \param cnt      \OUT counters, may be NULL
+ *  \param reset    \IN  1=reset counters
+ */
+void Z50SIM_Counters( Z50SIM_COUNTERS *cnt, int reset )
+{
+    if( cnt )
+        *cnt = G_sim.cnt;
+    if( reset )
+        memset( &G_sim.cnt, 0, sizeof(G_sim.cnt) );
+}
+
+/*==========================================================================+
+|  OSS                                                                      |
++==========================================================================*/
+
+char* OSS_Ident( void )
+{
+    return "OSS (z50_sim)";
+}
+
+void* OSS_MemGet( OSS_HANDLE *osh, u_int32 size, u_int32 *gotsizeP )
+{
+    void *p = malloc( size );
+
+    (void)osh;
+
+    *gotsizeP = p ? size : 0;
+    return p;
+}
+
+int32 OSS_MemFree( OSS_HANDLE *osh, void *addr, u_int32 size )
+{
+    (void)osh;
+    (void)size;
+    free( addr );
+    return 0;
+}
+
+void OSS_MemFill( OSS_HANDLE *osh, u_int32 size, char *adr, int8 value )
+{
+    (void)osh;
+    memset( adr, value, size );
+}
+
+void OSS_MemCopy( OSS_HANDLE *osh, u_int32 size, char *src, char *dest )
+{
+    (void)osh;
+    memmove( dest, src, size );
+}
+
+OSS_IRQ_STATE OSS_IrqMaskR( OSS_HANDLE *osh, OSS_IRQ_HANDLE *irqHdl )
+{
+    OSS_IRQ_STATE state;
+
+    (void)osh;
+    (void)irqHdl;
+
+    memset( &state, 0, sizeof(state) );
+    G_sim.maskDepth++;
+    return state;
+}
+
+void OSS_IrqRestore( OSS_HANDLE *osh, OSS_IRQ_HANDLE *irqHdl,
+                     OSS_IRQ_STATE oldState )
+{
+    (void)osh;
+    (void)irqHdl;
+    (void)oldState;
+    G_sim.maskDepth--;
+}
+
+int32 OSS_SigCreate( OSS_HANDLE *osh, int32 value, OSS_SIG_HANDLE **sigP )
+{
+    SIM_SIG *sig = malloc( sizeof(SIM_SIG) );
+
+    (void)osh;
+
+    if( !sig )
+        return ERR_OSS_MEM_ALLOC;
+
+    sig->signal = value;
+    *sigP = (OSS_SIG_HANDLE*)sig;
+    return 0;
+}
+
+int32 OSS_SigSend( OSS_HANDLE *osh, OSS_SIG_HANDLE *sigHdl )
+{
+    SIM_SIG *sig = (SIM_SIG*)sigHdl;
+
+    (void)osh;
+
+    G_sim.cnt.sigSent++;
+    if( sig->signal )
+        raise( sig->signal );
+    return 0;
+}
+
+int32 OSS_SigRemove( OSS_HANDLE *osh, OSS_SIG_HANDLE **sigP )
+{
+    (void)osh;
+    free( *sigP );
+    *sigP = NULL;
+    return 0;
+}
+
+int32 OSS_SemCreate( OSS_HANDLE *osh, int32 semType, int32 initVal,
+                     OSS_SEM_HANDLE **semP )
+{
+    SIM_SEM *sem = malloc( sizeof(SIM_SEM) );
+
+    (void)osh;
+
+    if( !sem )
+        return ERR_OSS_MEM_ALLOC;
+
+    sem->type  = semType;
+    sem->count = initVal;
+    *semP = (OSS_SEM_HANDLE*)sem;
+    return 0;
+}
+
+int32 OSS_SemRemove( OSS_HANDLE *osh, OSS_SEM_HANDLE **semP )
+{
+    (void)osh;
+    free( *semP );
+    *semP = NULL;
+    return 0;
+}
+
+/* blocks by running the virtual clock until signalled or timed out */
+int32 OSS_SemWait( OSS_HANDLE *osh, OSS_SEM_HANDLE *semHdl, int32 msec )
+{
+    SIM_SEM *sem = (SIM_SEM*)semHdl;
+    u_int64 end, t;
+
+    (void)osh;
+
+    end = msec < 0 ? SIM_NONE : G_sim.now + MS_NS(msec);
+
+    while( sem->count == 0 ){
+        if( G_sim.maskDepth || G_sim.inIrq ){
+            fprintf(stderr, "*** z50_sim: semaphore wait in irq context\n");
+            abort();
+        }
+
+        t = nextEvent();
+        if( t > end || t == SIM_NONE ){
+            /* nothing can signal: report timeout instead of hanging */
+            if( end != SIM_NONE )
+                G_sim.now = end;
+            return ERR_OSS_TIMEOUT;
+        }
+        step( t );
+    }
+    sem->count--;
+    return 0;
+}
+
+int32 OSS_SemSignal( OSS_HANDLE *osh, OSS_SEM_HANDLE *semHdl )
+{
+    SIM_SEM *sem = (SIM_SEM*)semHdl;
+
+    (void)osh;
+
+    if( sem->type == OSS_SEM_BIN )
+        sem->count = 1;
+    else
+        sem->count++;
+    return 0;
+}
+
+u_int32 OSS_TickGet( OSS_HANDLE *osh )
+{
+    (void)osh;
+    return (u_int32)(G_sim.now / MS_NS(1));
+}
+
+u_int32 OSS_TickRateGet( OSS_HANDLE *osh )
+{
+    (void)osh;
+    return 1000;
+}
+
+int32 OSS_AlarmCreate( OSS_HANDLE *osh, void (*funct)(void *arg), void *arg,
+                       OSS_ALARM_HANDLE **alarmP )
+{
+    SIM_ALARM *alm = calloc( 1, sizeof(SIM_ALARM) );
+
+    (void)osh;
+
+    if( !alm )
+        return ERR_OSS_MEM_ALLOC;
+
+    alm->fct  = funct;
+    alm->arg  = arg;
+    alm->link = G_sim.alarms;
+    G_sim.alarms = alm;
+
+    *alarmP = (OSS_ALARM_HANDLE*)alm;
+    return 0;
+}
+
+int32 OSS_AlarmRemove( OSS_HANDLE *osh, OSS_ALARM_HANDLE **alarmP )
+{
+    SIM_ALARM *alm = (SIM_ALARM*)*alarmP, **pp;
+
+    (void)osh;
+
+    for( pp=&G_sim.alarms; *pp; pp=&(*pp)->link ){
+        if( *pp == alm ){
+            *pp = alm->link;
+            break;
+        }
+    }
+    free( alm );
+    *alarmP = NULL;
+    return 0;
+}
+
+int32 OSS_AlarmSet( OSS_HANDLE *osh, OSS_ALARM_HANDLE *alarm, u_int32 msec,
+                    u_int32 cyclic, u_int32 *realMsecP )
+{
+    SIM_ALARM *alm = (SIM_ALARM*)alarm;
+
+    (void)osh;
+
+    if( alm->active )
+        return ERR_OSS_BUSY_RESOURCE;
+
+    if( msec == 0 )
+        msec = 1;                       /* one tick minimum */
+    if( G_sim.almRes > 1 )              /* round up to system tick */
+        msec = (msec + G_sim.almRes - 1) / G_sim.almRes * G_sim.almRes;
+
+    alm->period = MS_NS(msec);
+    alm->next   = G_sim.now + alm->period;
+    alm->cyclic = cyclic;
+    alm->active = 1;
+
+    if( realMsecP )
+        *realMsecP = msec;
+    return 0;
+}
+
+int32 OSS_AlarmClear( OSS_HANDLE *osh, OSS_ALARM_HANDLE *alarm )
+{
+    (void)osh;
+    ((SIM_ALARM*)alarm)->active = 0;
+    return 0;
+}
+
+int32 OSS_SpinLockCreate( OSS_HANDLE *osh, OSS_SPINL_HANDLE **spinlP )
+{
+    SIM_SPINL *sl = calloc( 1, sizeof(SIM_SPINL) );
+
+    (void)osh;
+
+    if( !sl )
+        return ERR_OSS_MEM_ALLOC;
+
+    *spinlP = (OSS_SPINL_HANDLE*)sl;
+    return 0;
+}
+
+int32 OSS_SpinLockRemove( OSS_HANDLE *osh, OSS_SPINL_HANDLE **spinlP )
+{
+    (void)osh;
+    free( *spinlP );
+    *spinlP = NULL;
+    return 0;
+}
+
+/* a nested acquire would dead-lock on the target */
+int32 OSS_SpinLockAcquire( OSS_HANDLE *osh, OSS_SPINL_HANDLE *spinl )
+{
+    SIM_SPINL *sl = (SIM_SPINL*)spinl;
+
+    (void)osh;
+
+    if( sl->held ){
+        fprintf(stderr, "*** z50_sim: spin lock dead-lock\n");
+        abort();
+    }
+    sl->held = 1;
+    return 0;
+}
+
+int32 OSS_SpinLockRelease( OSS_HANDLE *osh, OSS_SPINL_HANDLE *spinl )
+{
+    (void)osh;
+    ((SIM_SPINL*)spinl)->held = 0;
+    return 0;
+}
+
+/*==========================================================================+
+|  DESC                                                                     |
++==========================================================================*/
+
+char* DESC_Ident( void )
+{
+    return "DESC (z50_sim)";
+}
+
+int32 DESC_Init( DESC_SPEC *descSpec, OSS_HANDLE *osh, DESC_HANDLE **descHdlP )
+{
+    (void)osh;
+    *descHdlP = (DESC_HANDLE*)descSpec;
+    return 0;
+}
+
+int32 DESC_GetUInt32( DESC_HANDLE *descHdl, u_int32 defVal, u_int32 *valueP,
+                      char *keyFmt, ... )
+{
+    char key[SIM_KEYLEN];
+    va_list ap;
+    u_int32 i;
+
+    (void)descHdl;
+
+    va_start( ap, keyFmt );
+    vsnprintf( key, sizeof(key), keyFmt, ap );
+    va_end( ap );
+
+    for( i=0; i<G_sim.keyCnt; i++ ){
+        if( !strcmp( G_sim.key[i].key, key ) ){
+            *valueP = G_sim.key[i].value;
+            return 0;
+        }
+    }
+    *valueP = defVal;
+    return ERR_DESC_KEY_NOTFOUND;
+}
+
+int32 DESC_DbgLevelSet( DESC_HANDLE *descHdl, u_int32 dbgLevel )
+{
+    (void)descHdl;
+    (void)dbgLevel;
+    return 0;
+}
+
+int32 DESC_Exit( DESC_HANDLE **descHdlP )
+{
+    *descHdlP = NULL;
+    return 0;
+}
+
+/*==========================================================================+
+|  MDIS user API                                                            |
++==========================================================================*/
+
+/******************************** pathCh ************************************/
+/** Get current channel of path
+ *
+ *  \param path     \IN  path number
+ *
+ *  \return         channel or -1 for invalid path
+ */
+static int32 pathCh( MDIS_PATH path )
+{
+    if( path < 0 || path >= SIM_PATHS || G_sim.pathCh[path] < 0 ){
+        errno = ERR_OSS_ILL_PARAM;
+        return -1;
+    }
+    return G_sim.pathCh[path];
+}
+
+/******************************** apiDone ***********************************/
+/** Finish API call: deliver interrupts raised meanwhile, set errno
+ *
+ *  \param error    \IN  driver's return value
+ *
+ *  \return         0 or -1 on error
+ */
+static int32 apiDone( int32 error )
+{
+    irqDeliver();
+
+    if( error ){
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+/******************************** isBlkCode *********************************/
+/** Check for block status code (passes M_SG_BLOCK)
+ *
+ *  \param code     \IN  status code
+ *
+ *  \return         1 if block code
+ */
+static int isBlkCode( int32 code )
+{
+    return (code & ~0xff) == M_MK_BLK_OF ||
+           (code & ~0xff) == M_LL_BLK_OF ||
+           (code & ~0xff) == M_DEV_BLK_OF;
+}
+
+MDIS_PATH M_open( const char *device )
+{
+    MACCESS ma;
+    int32 error;
+    u_int32 addrMode, dataMode, size, gip;
+    MDIS_PATH path;
+
+    simInit();
+
+    for( path=0; path<SIM_PATHS && G_sim.pathCh[path] >= 0; path++ )
+        ;
+    if( path == SIM_PATHS ){
+        errno = ERR_OSS_BUSY_RESOURCE;
+        return -1;
+    }
+
+    /* first open: configure from device name, init driver */
+    if( !G_sim.llHdl ){
+        if( strstr( device, "d302i" ) )
+            Z50SIM_Config( 1, strstr( device, "gip" ) != NULL );
+        else if( strstr( device, "bioc" ) )
+            Z50SIM_Config( 0, 0 );
+
+        LL_GetEntry( &G_sim.entry );
+
+        /* window as announced by the driver, Z50_D302I_GIP requires the
+           board mapping to cover the D302i control register as well */
+        G_sim.entry.info( LL_INFO_ADDRSPACE, 0, &addrMode, &dataMode,
+                          &size );
+        DESC_GetUInt32( (DESC_HANDLE*)G_sim.key, 0, &gip, "Z50_D302I_GIP" );
+        if( G_sim.dev.d302i && gip && size < D302I_SIZE )
+            size = D302I_SIZE;
+        G_sim.dev.size = size;
+        if( (error = OSS_SemCreate( NULL, OSS_SEM_BIN, 0, &G_sim.devSem )) ){
+            errno = error;
+            return -1;
+        }
+
+        ma = &G_sim.dev;
+        if( (error = G_sim.entry.init( (DESC_SPEC*)G_sim.key, NULL, &ma,
+                                       G_sim.devSem,
+                                       (OSS_IRQ_HANDLE*)&G_sim,
+                                       &G_sim.llHdl )) ){
+            OSS_SemRemove( NULL, &G_sim.devSem );
+            G_sim.llHdl = NULL;
+            errno = error;
+            return -1;
+        }
+    }
+
+    G_sim.pathCh[path] = 0;
+    G_sim.pathCnt++;
+    return path;
+}
+
+int32 M_close( MDIS_PATH path )
+{
+    int32 error = 0;
+
+    if( pathCh( path ) < 0 )
+        return -1;
+
+    G_sim.pathCh[path] = -1;
+
+    /* last close: de-init driver */
+    if( --G_sim.pathCnt == 0 ){
+        error = G_sim.entry.exit( &G_sim.llHdl );
+        G_sim.llHdl     = NULL;
+        G_sim.irqEnable = 0;
+        OSS_SemRemove( NULL, &G_sim.devSem );
+    }
+    return apiDone( error );
+}
+
+int32 M_read( MDIS_PATH path, int32 *valueP )
+{
+    int32 ch = pathCh( path );
+
+    if( ch < 0 )
+        return -1;
+    return apiDone( G_sim.entry.read( G_sim.llHdl, ch, valueP ) );
+}
+
+int32 M_write( MDIS_PATH path, int32 value )
+{
+    int32 ch = pathCh( path );
+
+    if( ch < 0 )
+        return -1;
+    return apiDone( G_sim.entry.write( G_sim.llHdl, ch, value ) );
+}
+
+int32 M_setstat( MDIS_PATH path, int32 code, INT32_OR_64 data )
+{
+    int32 ch = pathCh( path );
+
+    if( ch < 0 )
+        return -1;
+
+    if( code == M_MK_CH_CURRENT ){
+        G_sim.pathCh[path] = (int32)data;
+        return 0;
+    }
+
+    if( code == M_MK_IRQ_ENABLE )
+        G_sim.irqEnable = (int)data;
+
+    return apiDone( G_sim.entry.setStat( G_sim.llHdl, code, ch, data ) );
+}
+
+int32 M_getstat( MDIS_PATH path, int32 code, int32 *dataP )
+{
+    int32 ch = pathCh( path );
+    INT32_OR_64 value = 0;
+    int32 error;
+
+    if( ch < 0 )
+        return -1;
+
+    if( code == M_MK_CH_CURRENT ){
+        *dataP = ch;
+        return 0;
+    }
+
+    /* handled by the MDIS kernel */
+    if( code == M_MK_IRQ_ENABLE ){
+        *dataP = G_sim.irqEnable;
+        return 0;
+    }
+
+    /* block codes pass the M_SG_BLOCK through */
+    if( isBlkCode( code ) )
+        return apiDone( G_sim.entry.getStat( G_sim.llHdl, code, ch,
+                                             (INT32_OR_64*)dataP ) );
+
+    error = G_sim.entry.getStat( G_sim.llHdl, code, ch, &value );
+    if( !error )
+        *dataP = (int32)value;
+    return apiDone( error );
+}
+
+int32 M_getblock( MDIS_PATH path, u_int8 *buffer, int32 length )
+{
+    int32 ch = pathCh( path );
+    int32 nbr = 0;
+
+    if( ch < 0 )
+        return -1;
+    if( apiDone( G_sim.entry.blockRead( G_sim.llHdl, ch, buffer, length,
+                                        &nbr ) ) )
+        return -1;
+    return nbr;
+}
+
+int32 M_setblock( MDIS_PATH path, const u_int8 *buffer, int32 length )
+{
+    int32 ch = pathCh( path );
+    int32 nbr = 0;
+
+    if( ch < 0 )
+        return -1;
+    if( apiDone( G_sim.entry.blockWrite( G_sim.llHdl, ch, (void*)buffer,
+                                         length, &nbr ) ) )
+        return -1;
+    return nbr;
+}
+
+char* M_errstring( int32 errCode )
+{
+    static char buf[64];
+
+    sprintf( buf, "ERROR (z50_sim) 0x%04x", (unsigned)errCode );
+    return buf;
+}
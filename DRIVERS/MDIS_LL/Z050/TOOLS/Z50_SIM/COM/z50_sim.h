@@ -0,0 +1,117 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z50_sim.h
+ *
+ *      \author  ulrich.bogensperger@men.de
+ *
+ *       \brief  Register-level simulator for the Z50 low-level driver
+ *
+ *  Included by z50_drv.c instead of <MEN/maccess.h> when the driver is
+ *  built with Z50_SIM. All register accesses are then routed into a
+ *  model of the BIOC/D302i register window which runs on a virtual
+ *  clock, so the driver can be exercised on a host without hardware.
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2004-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _Z50_SIM_H
+#define _Z50_SIM_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/* replaces <MEN/maccess.h> for the driver */
+#ifndef _MACCESS_H
+# define _MACCESS_H
+typedef struct Z50SIM_DEV *MACCESS;     /**< simulated register window */
+
+# define MREAD_D32(ma,offs)         Z50SIM_Read( (ma), (offs) )
+# define MWRITE_D32(ma,offs,val)    Z50SIM_Write( (ma), (offs), (val) )
+# define MSETMASK_D32(ma,offs,mask) \
+    Z50SIM_Write( (ma), (offs), Z50SIM_Read( (ma), (offs) ) | (mask) )
+# define MCLRMASK_D32(ma,offs,mask) \
+    Z50SIM_Write( (ma), (offs), Z50SIM_Read( (ma), (offs) ) & ~(mask) )
+#endif
+
+/** simulator counters (see Z50SIM_Counters()) */
+typedef struct {
+    u_int32 regRead;        /**< register reads */
+    u_int32 regWrite;       /**< register writes */
+    u_int32 irqCall;        /**< calls of the driver's Irq entry */
+    u_int32 irqOwn;         /**< ... which reported LL_IRQ_DEVICE */
+    u_int32 irqStuck;       /**< pending irq not cleared by the driver */
+    u_int32 alarmCall;      /**< alarm handler calls */
+    u_int32 sigSent;        /**< signals sent by the driver */
+} Z50SIM_COUNTERS;
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+/* timestamps for the driver's statistics and histograms, microseconds
+   unless changed with Z50SIM_TsRate() */
+#define Z50_TIMESTAMP()         Z50SIM_TsGet()      /**< timestamp */
+#define Z50_TIMESTAMP_RATE()    Z50SIM_TsRateGet()  /**< ticks/sec */
+
+#define Z50SIM_DEBOUNCE_NS      50000   /**< duration of debounce unit */
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+/* register window, used by the driver */
+extern u_int32 Z50SIM_Read( MACCESS ma, u_int32 offs );
+extern void    Z50SIM_Write( MACCESS ma, u_int32 offs, u_int32 val );
+
+/* configuration, before M_open() */
+extern void    Z50SIM_Config( int d302i, int gip );
+extern int32   Z50SIM_DescSet( const char *key, u_int32 value );
+extern void    Z50SIM_AccessCost( u_int32 nsec );
+extern void    Z50SIM_AlarmRes( u_int32 msec );
+extern void    Z50SIM_TsRate( u_int32 rate );
+
+/* virtual clock */
+extern u_int32 Z50SIM_TimeUs( void );
+extern u_int32 Z50SIM_TsGet( void );
+extern u_int32 Z50SIM_TsRateGet( void );
+extern void    Z50SIM_Run( u_int32 usec );
+
+/* stimulus */
+extern void    Z50SIM_Input( u_int32 ch, u_int32 mask, u_int32 value );
+extern int32   Z50SIM_Stim( u_int32 delay, u_int32 ch, u_int32 mask,
+                            u_int32 value );
+extern int32   Z50SIM_Bounce( u_int32 ch, u_int32 mask, u_int32 value,
+                              u_int32 count, u_int32 interval );
+extern int32   Z50SIM_Clock( u_int32 ch, u_int32 mask, u_int32 half,
+                             u_int32 count );
+extern void    Z50SIM_Loopback( u_int32 mask );
+extern u_int32 Z50SIM_Output( u_int32 ch );
+extern u_int32 *Z50SIM_Map( void );
+
+/* interrupt injector and counters */
+extern int32   Z50SIM_IrqInject( void );
+extern void    Z50SIM_Counters( Z50SIM_COUNTERS *cnt, int reset );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z50_SIM_H */
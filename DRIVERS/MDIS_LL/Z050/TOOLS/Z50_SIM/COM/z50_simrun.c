@@ -0,0 +1,583 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z50_SIMRUN                       ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z50_simrun.c
+ *       \author ulrich.bogensperger@men.de
+ *
+ *       \brief  Run Z50 driver against the register-level simulator
+ *
+ *  Reads a script of stimulus and driver calls and executes it on the
+ *  host build of the driver (see z50_sim.c). Every line holds one
+ *  command, numbers may be decimal or hex (0x...), '#' starts a comment:
+ *
+ *  \code
+ *  ch <n>                          select channel (M_MK_CH_CURRENT)
+ *  setstat <code> <value>          M_setstat(), code by name or number
+ *  getstat <code>                  M_getstat() and print value
+ *  setblk <code> <word>...         block M_setstat() with the words
+ *  getblk <code> [<word>...]       block M_getstat(), the words preset
+ *                                  the parameter block, print the result
+ *                                  (<code>/<bytes> sets the block size)
+ *  read                            M_read() and print value
+ *  write <value>                   M_write()
+ *  setblock <word>...              M_setblock() with the words
+ *  getblock <bytes>                M_getblock() and print the result
+ *  in <mask> <value>               change input pins now
+ *  stim <delay> <mask> <value>     change input pins in <delay> us
+ *  bounce <mask> <value> <n> <us>  bouncing contact, settles on <value>
+ *  clock <mask> <half> <n>         <n> periods square wave, <half> us
+ *  loop <mask>                     connect outputs to inputs
+ *  run <us>                        advance virtual time
+ *  irq                             inject foreign interrupt
+ *  events                          print queued edge events
+ *  map                             read input/output with z50_map.h
+ *  counters                        print (and reset) simulator counters
+ *  echo <text>                     print text
+ *  fail <command>                  command must fail
+ *  \endcode
+ *
+ *  Stimulus commands act on the current channel. Block results are
+ *  printed as 32 bit words, words that are 0 are left out.
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2004-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/z50_drv.h>
+#include <MEN/z50_map.h>
+#include "z50_sim.h"
+
+static const char IdentString[]=MENT_XSTR(MAK_REVISION);
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MAX_ARGS        16          /* max. arguments per command */
+#define EVT_RECS        64          /* events read per request */
+#define BLK_WORDS       1024        /* max. size of block data [words] */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+typedef struct {
+    const char *name;
+    int32       code;
+    int32       size;               /* parameter block size, 0=value */
+} CODE_NAME;
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+#define CODE(c)     { #c, c, 0 }
+#define BLK(c,t)    { #c, c, sizeof(t) }
+static const CODE_NAME G_codes[] = {
+    CODE(M_MK_IRQ_ENABLE),
+    CODE(M_LL_IRQ_COUNT),
+    CODE(M_LL_CH_NUMBER),
+    CODE(Z50_SET_PORTS),
+    CODE(Z50_CLR_PORTS),
+    CODE(Z50_EDGE_RAISE),
+    CODE(Z50_EDGE_FALL),
+    CODE(Z50_IRQ_EDGE_RAISE),
+    CODE(Z50_IRQ_EDGE_FALL),
+    CODE(Z50_SET_SIGNAL),
+    CODE(Z50_CLR_SIGNAL),
+    CODE(Z50_SHADOW_CHECK),
+    CODE(Z50_FREQ_INPUTS),
+    CODE(Z50_FREQ_GATE),
+    CODE(Z50_SETBLOCK_MODE),
+    CODE(Z50_WAVE_LOOPS),
+    CODE(Z50_WAVE_STOP),
+    CODE(Z50_WAVE_STATE),
+    CODE(Z50_WAVE_SIGNAL),
+    CODE(Z50_PWM_OUTPUTS),
+    CODE(Z50_GETBLOCK_MODE),
+    CODE(Z50_SAMPLE_PERIOD),
+    CODE(Z50_SAMPLING),
+    CODE(Z50_SAMPLE_FORMAT),
+    CODE(Z50_NOTIFY_HOLDOFF),
+    CODE(Z50_NOTIFY_THRESHOLD),
+    CODE(Z50_QUAR_THRESHOLD),
+    CODE(Z50_QUAR_WINDOW),
+    CODE(Z50_QUAR_BACKOFF),
+    CODE(Z50_QUAR_INPUTS),
+    CODE(Z50_HISTOGRAM),
+    CODE(Z50_TIMER_TICK),
+    BLK(Z50_BLK_DEBOUNCE,   Z50_DEBOUNCE_PB),
+    BLK(Z50_BLK_WAIT_EDGE,  Z50_WAIT_PB),
+    BLK(Z50_BLK_EDGE_COUNT, Z50_EDGE_COUNT_PB),
+    BLK(Z50_BLK_FREQ,       Z50_FREQ_PB),
+    BLK(Z50_BLK_WAVE_WAIT,  Z50_WAVE_WAIT_PB),
+    BLK(Z50_BLK_PWM,        Z50_PWM_PB),
+    BLK(Z50_BLK_QUARANTINE, Z50_QUAR_PB),
+    BLK(Z50_BLK_HIST,       Z50_HIST_PB),
+    BLK(Z50_BLK_STATS,      Z50_STATS_PB),
+    BLK(Z50_BLK_EDGE_ALL,   Z50_EDGE_ALL_PB),
+    BLK(Z50_BLK_STATUS,     Z50_STATUS_PB),
+    BLK(Z50_BLK_LAYOUT,     Z50_LAYOUT_PB),
+    { NULL, 0, 0 }
+};
+
+static u_int8  G_evtBuf[sizeof(Z50_EVENT_HDR) + EVT_RECS*sizeof(Z50_EVENT)];
+static u_int32 G_blkBuf[BLK_WORDS];
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void usage(void);
+static int  codeGet( const char *str, int32 *codeP, int32 *sizeP );
+static int  execute( MDIS_PATH path, int argc, char **argv );
+static int  printEvents( MDIS_PATH path );
+static void printWords( const char *name, const u_int32 *buf,
+                        int32 size );
+static int  printMap( MDIS_PATH path, u_int32 ch );
+
+
+/********************************* usage ***********************************/
+/**  Print program usage
+ */
+static void usage(void)
+{
+    printf("Usage: z50_simrun [<opts>] <script> [<opts>]\n");
+    printf("Function: Run Z50 driver against register-level simulator\n");
+    printf("Options:\n");
+    printf("  script       command file, - for stdin....... [none]    \n");
+    printf("  -d           simulate D302i ................. [BIOC]    \n");
+    printf("  -g           use D302i GIP/GIEN ............. [no]      \n");
+    printf("  -k=<key>=<n> set descriptor key ............. [-]       \n");
+    printf("  -a=<ns>      time per register access ....... [0]       \n");
+    printf("  -r=<n>       timestamp rate [1/s] ........... [1000000] \n");
+    printf("  -t=<ms>      OS alarm resolution ............ [1]       \n");
+    printf("\n");
+    printf("Copyright 2004-2019, MEN Mikro Elektronik GmbH\n%s\n", IdentString);
+}
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return           success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+    char      *script = NULL, *key, *val, *args[MAX_ARGS+1];
+    char      line[256], *p;
+    int       d302i = 0, gip = 0, i, n, lineNo = 0, ret = 0;
+    FILE      *fp;
+    MDIS_PATH path;
+
+    /*--------------------+
+    |  get arguments      |
+    +--------------------*/
+    for( i=1; i<argc; i++ ) {
+        if( !strcmp( argv[i], "-d" ) )
+            d302i = 1;
+        else if( !strcmp( argv[i], "-g" ) )
+            gip = 1;
+        else if( !strncmp( argv[i], "-a=", 3 ) )
+            Z50SIM_AccessCost( strtoul( argv[i]+3, NULL, 0 ) );
+        else if( !strncmp( argv[i], "-r=", 3 ) )
+            Z50SIM_TsRate( strtoul( argv[i]+3, NULL, 0 ) );
+        else if( !strncmp( argv[i], "-t=", 3 ) )
+            Z50SIM_AlarmRes( strtoul( argv[i]+3, NULL, 0 ) );
+        else if( !strncmp( argv[i], "-k=", 3 ) &&
+                 (val = strchr( argv[i]+3, '=' )) ) {
+            key = argv[i]+3;
+            *val++ = '\0';
+            Z50SIM_DescSet( key, strtoul( val, NULL, 0 ) );
+        }
+        else if( *argv[i] != '-' || !strcmp( argv[i], "-" ) )
+            script = argv[i];
+        else {
+            usage();
+            return(1);
+        }
+    }
+
+    if( !script ) {
+        usage();
+        return(1);
+    }
+
+    if( !strcmp( script, "-" ) )
+        fp = stdin;
+    else if( (fp = fopen( script, "r" )) == NULL ) {
+        printf("*** can't open %s: %s\n", script, strerror(errno));
+        return(1);
+    }
+
+    /*--------------------+
+    |  open path          |
+    +--------------------*/
+    Z50SIM_Config( d302i, gip );
+
+    /* signals sent by the driver are only counted */
+    signal( SIGUSR1, SIG_IGN );
+    signal( SIGUSR2, SIG_IGN );
+
+    if( (path = M_open( "z50_sim" )) < 0 ) {
+        printf("*** open: %s\n", M_errstring( errno ));
+        return(1);
+    }
+
+    /*--------------------+
+    |  execute script     |
+    +--------------------*/
+    while( fgets( line, sizeof(line), fp ) ) {
+        lineNo++;
+
+        if( (p = strchr( line, '#' )) )
+            *p = '\0';
+
+        for( n=0, p=strtok( line, " \t\r\n" ); p && n<=MAX_ARGS;
+             p=strtok( NULL, " \t\r\n" ) )
+            args[n++] = p;
+
+        if( n == 0 )
+            continue;
+
+        if( execute( path, n, args ) ) {
+            printf("*** line %d: %s failed\n", lineNo, args[0]);
+            ret = 1;
+            break;
+        }
+    }
+
+    if( fp != stdin )
+        fclose( fp );
+
+    if( M_close( path ) < 0 ) {
+        printf("*** close: %s\n", M_errstring( errno ));
+        ret = 1;
+    }
+
+    return(ret);
+}
+
+/********************************* codeGet *********************************/
+/** Translate status code name or number
+ *
+ *  \param str        \IN  name or number
+ *  \param codeP      \OUT status code
+ *  \param sizeP      \OUT parameter block size (0 if unknown)
+ *
+ *  \return           0 on success, -1 if unknown
+ */
+static int codeGet( const char *str, int32 *codeP, int32 *sizeP )
+{
+    const CODE_NAME *c;
+    char *end;
+
+    for( c=G_codes; c->name; c++ ) {
+        if( !strcmp( c->name, str ) ) {
+            *codeP = c->code;
+            *sizeP = c->size;
+            return 0;
+        }
+    }
+
+    *codeP = (int32)strtoul( str, &end, 0 );
+    *sizeP = 0;
+    return *end ? -1 : 0;
+}
+
+/********************************* execute *********************************/
+/** Execute one script command
+ *
+ *  \param path       \IN  MDIS path
+ *  \param argc       \IN  number of words
+ *  \param argv       \IN  command and arguments
+ *
+ *  \return           0 on success, -1 on error
+ */
+static int execute( MDIS_PATH path, int argc, char **argv )
+{
+    static int32 ch = 0;
+    const char *cmd = argv[0];
+    u_int32 arg[MAX_ARGS];
+    int32 code, value, size;
+    Z50SIM_COUNTERS cnt;
+    M_SG_BLOCK blk;
+    char *p;
+    int i;
+
+    for( i=1; i<argc; i++ )
+        arg[i-1] = strtoul( argv[i], NULL, 0 );
+
+    if( !strcmp( cmd, "echo" ) ) {
+        for( i=1; i<argc; i++ )
+            printf("%s%s", argv[i], i+1 < argc ? " " : "\n");
+        return 0;
+    }
+
+    if( !strcmp( cmd, "fail" ) && argc > 1 ) {
+        if( execute( path, argc-1, argv+1 ) == 0 ) {
+            printf("%s did not fail\n", argv[1]);
+            return -1;
+        }
+        return 0;
+    }
+
+    if( !strcmp( cmd, "ch" ) && argc == 2 ) {
+        ch = arg[0];
+        return M_setstat( path, M_MK_CH_CURRENT, ch );
+    }
+
+    if( !strcmp( cmd, "setstat" ) && argc == 3 ) {
+        if( codeGet( argv[1], &code, &size ) )
+            return -1;
+        if( M_setstat( path, code, (INT32_OR_64)(int32)arg[1] ) < 0 ) {
+            printf("setstat %s: %s\n", argv[1], M_errstring( errno ));
+            return -1;
+        }
+        return 0;
+    }
+
+    if( !strcmp( cmd, "getstat" ) && argc == 2 ) {
+        if( codeGet( argv[1], &code, &size ) )
+            return -1;
+        if( M_getstat( path, code, &value ) < 0 ) {
+            printf("getstat %s: %s\n", argv[1], M_errstring( errno ));
+            return -1;
+        }
+        printf("%10u us: %s = 0x%08x\n", Z50SIM_TimeUs(), argv[1], value);
+        return 0;
+    }
+
+    /* block codes: words preset the parameter block, rest is 0 */
+    if( (!strcmp( cmd, "setblk" ) || !strcmp( cmd, "getblk" )) &&
+        argc >= 2 ) {
+        /* <code>/<bytes> overrides the size of the parameter block */
+        if( (p = strchr( argv[1], '/' )) )
+            *p++ = '\0';
+        if( codeGet( argv[1], &code, &size ) )
+            return -1;
+        if( p )
+            size = strtoul( p, NULL, 0 );
+        else if( size == 0 )
+            size = (argc - 2) * 4;
+        if( size > (int32)sizeof(G_blkBuf) )
+            return -1;
+
+        memset( G_blkBuf, 0, sizeof(G_blkBuf) );
+        for( i=2; i<argc; i++ )
+            G_blkBuf[i-2] = arg[i-1];
+        blk.data = G_blkBuf;
+        blk.size = size;
+
+        if( cmd[0] == 's' ) {
+            if( M_setstat( path, code, (INT32_OR_64)&blk ) < 0 ) {
+                printf("setblk %s: %s\n", argv[1], M_errstring( errno ));
+                return -1;
+            }
+            return 0;
+        }
+
+        if( M_getstat( path, code, (int32*)&blk ) < 0 ) {
+            printf("getblk %s: %s\n", argv[1], M_errstring( errno ));
+            return -1;
+        }
+        printWords( argv[1], G_blkBuf, size );
+        return 0;
+    }
+
+    if( !strcmp( cmd, "read" ) && argc == 1 ) {
+        if( M_read( path, &value ) < 0 )
+            return -1;
+        printf("%10u us: input = 0x%08x\n", Z50SIM_TimeUs(), value);
+        return 0;
+    }
+
+    if( !strcmp( cmd, "write" ) && argc == 2 )
+        return M_write( path, arg[0] );
+
+    if( !strcmp( cmd, "setblock" ) && argc >= 2 ) {
+        for( i=1; i<argc; i++ )
+            G_blkBuf[i-1] = arg[i-1];
+        if( (value = M_setblock( path, (u_int8*)G_blkBuf,
+                                 (argc-1) * 4 )) < 0 ) {
+            printf("setblock: %s\n", M_errstring( errno ));
+            return -1;
+        }
+        printf("%10u us: setblock = %d\n", Z50SIM_TimeUs(), value);
+        return 0;
+    }
+
+    if( !strcmp( cmd, "getblock" ) && argc == 2 &&
+        arg[0] <= sizeof(G_blkBuf) ) {
+        memset( G_blkBuf, 0, sizeof(G_blkBuf) );
+        if( (value = M_getblock( path, (u_int8*)G_blkBuf, arg[0] )) < 0 ) {
+            printf("getblock: %s\n", M_errstring( errno ));
+            return -1;
+        }
+        printWords( "getblock", G_blkBuf, value );
+        return 0;
+    }
+
+    if( !strcmp( cmd, "in" ) && argc == 3 ) {
+        Z50SIM_Input( ch, arg[0], arg[1] );
+        return 0;
+    }
+
+    if( !strcmp( cmd, "stim" ) && argc == 4 )
+        return Z50SIM_Stim( arg[0], ch, arg[1], arg[2] ) ? -1 : 0;
+
+    if( !strcmp( cmd, "bounce" ) && argc == 5 )
+        return Z50SIM_Bounce( ch, arg[0], arg[1], arg[2], arg[3] ) ? -1 : 0;
+
+    if( !strcmp( cmd, "clock" ) && argc == 4 )
+        return Z50SIM_Clock( ch, arg[0], arg[1], arg[2] ) ? -1 : 0;
+
+    if( !strcmp( cmd, "loop" ) && argc == 2 ) {
+        Z50SIM_Loopback( arg[0] );
+        return 0;
+    }
+
+    if( !strcmp( cmd, "run" ) && argc == 2 ) {
+        Z50SIM_Run( arg[0] );
+        return 0;
+    }
+
+    if( !strcmp( cmd, "irq" ) && argc == 1 ) {
+        printf("%10u us: irq = %d\n", Z50SIM_TimeUs(), Z50SIM_IrqInject());
+        return 0;
+    }
+
+    if( !strcmp( cmd, "events" ) && argc == 1 )
+        return printEvents( path );
+
+    if( !strcmp( cmd, "map" ) && argc == 1 )
+        return printMap( path, ch );
+
+    if( !strcmp( cmd, "counters" ) && argc == 1 ) {
+        Z50SIM_Counters( &cnt, 1 );
+        printf("%10u us: reads=%u writes=%u irq=%u own=%u stuck=%u "
+               "alarms=%u signals=%u\n", Z50SIM_TimeUs(),
+               cnt.regRead, cnt.regWrite, cnt.irqCall, cnt.irqOwn,
+               cnt.irqStuck, cnt.alarmCall, cnt.sigSent);
+        return 0;
+    }
+
+    printf("unknown command or wrong arguments: %s\n", cmd);
+    return -1;
+}
+
+/********************************* printEvents *****************************/
+/** Read and print all queued edge events
+ *
+ *  \param path       \IN  MDIS path
+ *
+ *  \return           0 on success, -1 on error
+ */
+static int printEvents( MDIS_PATH path )
+{
+    Z50_EVENT_HDR *hdr = (Z50_EVENT_HDR*)G_evtBuf;
+    Z50_EVENT *evt = (Z50_EVENT*)(hdr + 1);
+    M_SG_BLOCK blk;
+    u_int32 i;
+
+    do {
+        blk.data = G_evtBuf;
+        blk.size = sizeof(G_evtBuf);
+
+        if( M_getstat( path, Z50_BLK_EVENTS, (int32*)&blk ) < 0 ) {
+            printf("getstat Z50_BLK_EVENTS: %s\n", M_errstring( errno ));
+            return -1;
+        }
+
+        for( i=0; i<hdr->count; i++ )
+            printf("%10u us: event %u ch=%u raise=0x%08x fall=0x%08x "
+                   "input=0x%08x\n",
+                   (u_int32)((u_int64)evt[i].time * 1000000 / hdr->tickRate),
+                   evt[i].seq, evt[i].ch, evt[i].raise, evt[i].fall,
+                   evt[i].input);
+
+        if( hdr->lost )
+            printf("%10u us: %u events lost\n", Z50SIM_TimeUs(), hdr->lost);
+
+    } while( hdr->pending );
+
+    return 0;
+}
+
+/********************************* printMap ********************************/
+/** Read input and output register through the z50_map.h accessors
+ *
+ *  Uses the layout from Z50_BLK_LAYOUT on the simulator's image of the
+ *  register window, like an application with its own user mapping.
+ *
+ *  \param path       \IN  MDIS path
+ *  \param ch         \IN  channel
+ *
+ *  \return           0 on success, -1 on error
+ */
+static int printMap( MDIS_PATH path, u_int32 ch )
+{
+    Z50_LAYOUT_PB lay;
+    M_SG_BLOCK blk;
+    Z50_MAP m;
+
+    blk.data = &lay;
+    blk.size = sizeof(lay);
+
+    if( M_getstat( path, Z50_BLK_LAYOUT, (int32*)&blk ) < 0 ) {
+        printf("getstat Z50_BLK_LAYOUT: %s\n", M_errstring( errno ));
+        return -1;
+    }
+
+    m = Z50SIM_Map();
+    printf("%10u us: map hw=%u ch=%u size=0x%x input=0x%08x "
+           "output=0x%08x\n", Z50SIM_TimeUs(), lay.hwType, lay.numCh,
+           lay.size, Z50_MAP_INPUT( m, &lay, ch ),
+           Z50_MAP_OUTPUT( m, &lay, ch ));
+    return 0;
+}
+
+/********************************* printWords ******************************/
+/** Print block data as 32 bit words, leaving out words that are 0
+ *
+ *  \param name       \IN  title
+ *  \param buf        \IN  data
+ *  \param size       \IN  size of data [bytes]
+ */
+static void printWords( const char *name, const u_int32 *buf, int32 size )
+{
+    int32 i, n = 0;
+
+    printf("%10u us: %s (%d bytes)", Z50SIM_TimeUs(), name, size);
+
+    for( i=0; i < size/4; i++ ) {
+        if( buf[i] == 0 )
+            continue;
+        printf("%s[%d]=0x%x", n++ % 6 ? " " : "\n            ", i, buf[i]);
+    }
+    printf("\n");
+}
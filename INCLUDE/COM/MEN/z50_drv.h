@@ -39,6 +39,15 @@
 #endif
 
 
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z50_MAX_CH         4           /**< max. number of channels */
+#define Z50_NUM_INPUTS     32          /**< number of inputs per channel */
+#define Z50_HIST_BUCKETS   32          /**< number of histogram buckets */
+#define Z50_STAT_CODES     32          /**< counted codes M_DEV_OF+n */
+#define Z50_STAT_BLK_CODES 16          /**< counted codes M_DEV_BLK_OF+n */
+
 /*-----------------------------------------+
 |  TYPEDEFS                                |
 +-----------------------------------------*/
@@ -47,6 +56,196 @@ typedef struct {
     int time;                          /**< Debouncing time (see docs) */
 } Z50_DEBOUNCE_PB;
 
+/** Edge event record (see Z50_BLK_EVENTS) */
+typedef struct {
+    u_int32 seq;                       /**< Event sequence number */
+    u_int32 time;                      /**< Timestamp of interrupt */
+    u_int32 ch;                        /**< Channel of event */
+    u_int32 raise;                     /**< Inputs with raising edge */
+    u_int32 fall;                      /**< Inputs with falling edge */
+    u_int32 input;                     /**< State of inputs */
+} Z50_EVENT;
+
+/** Header for Z50_BLK_EVENTS, followed by Z50_EVENT records */
+typedef struct {
+    u_int32 count;                     /**< Number of returned events */
+    u_int32 pending;                   /**< Events still queued in driver */
+    u_int32 lost;                      /**< Events lost since last request */
+    u_int32 lostTotal;                 /**< Events lost since init */
+    u_int32 tickRate;                  /**< Timestamp rate [1/s] */
+} Z50_EVENT_HDR;
+
+/** Parameter block for Z50_BLK_WAIT_EDGE */
+typedef struct {
+    u_int32 raiseMask;                 /**< IN:  Inputs to wait for raising
+                                            edge */
+    u_int32 fallMask;                  /**< IN:  Inputs to wait for falling
+                                            edge */
+    int32   timeout;                   /**< IN:  Timeout [ms] (-1=forever,
+                                            0=don't wait) */
+    u_int32 raise;                     /**< OUT: Matching raising edges */
+    u_int32 fall;                      /**< OUT: Matching falling edges */
+} Z50_WAIT_PB;
+
+/** Parameter block for Z50_BLK_EDGE_COUNT */
+typedef struct {
+    u_int32 reset;                     /**< IN:  Reset counters if 1 */
+    u_int32 numCh;                     /**< OUT: Number of valid channels */
+    u_int64 raise[Z50_MAX_CH][Z50_NUM_INPUTS]; /**< OUT: Raising edges per
+                                                    input */
+    u_int64 fall[Z50_MAX_CH][Z50_NUM_INPUTS];  /**< OUT: Falling edges per
+                                                    input */
+} Z50_EDGE_COUNT_PB;
+
+/** Parameter block for Z50_BLK_EDGE_ALL */
+typedef struct {
+    u_int32 numCh;                     /**< OUT: Number of valid channels */
+    u_int32 raise[Z50_MAX_CH];         /**< OUT: Inputs with raising edge
+                                            per channel */
+    u_int32 fall[Z50_MAX_CH];          /**< OUT: Inputs with falling edge
+                                            per channel */
+} Z50_EDGE_ALL_PB;
+
+/** Parameter block for Z50_BLK_STATUS */
+typedef struct {
+    u_int32 input;                     /**< OUT: State of inputs */
+    u_int32 raise;                     /**< OUT: Inputs with raising edge */
+    u_int32 fall;                      /**< OUT: Inputs with falling edge */
+    u_int32 irqCount;                  /**< OUT: Interrupt counter (see
+                                            M_LL_IRQ_COUNT) */
+} Z50_STATUS_PB;
+
+/** Parameter block for Z50_BLK_LAYOUT (see z50_map.h) */
+typedef struct {
+    u_int32 hwType;                    /**< OUT: Z50_HW_BIOC/D302I */
+    u_int32 numCh;                     /**< OUT: Number of valid channels */
+    u_int32 size;                      /**< OUT: Size of address space
+                                            mapped by MDIS [bytes] */
+    u_int32 input;                     /**< OUT: Offset of input register
+                                            of channel 0 */
+    u_int32 output;                    /**< OUT: Offset of output register
+                                            of channel 0 */
+    u_int32 chStride;                  /**< OUT: Offset between registers
+                                            of two channels */
+} Z50_LAYOUT_PB;
+
+/** Measurement results of one input (see Z50_BLK_FREQ) */
+typedef struct {
+    u_int32 period;                    /**< Last period [ticks] */
+    u_int32 minPeriod;                 /**< Shortest period [ticks] */
+    u_int32 maxPeriod;                 /**< Longest period [ticks] */
+    u_int32 gatePeriods;               /**< Periods in last gate */
+    u_int32 gateTime;                  /**< Length of last gate [ticks] */
+    u_int32 freq;                      /**< Average frequency in last
+                                            gate [Hz] */
+} Z50_FREQ;
+
+/** Parameter block for Z50_BLK_FREQ */
+typedef struct {
+    u_int32  reset;                    /**< IN:  Reset min/max if 1 */
+    u_int32  numCh;                    /**< OUT: Number of valid channels */
+    u_int32  tickRate;                 /**< OUT: Timestamp rate [1/s] */
+    Z50_FREQ in[Z50_MAX_CH][Z50_NUM_INPUTS]; /**< OUT: Results per input */
+} Z50_FREQ_PB;
+
+/** Output waveform step (M_setblock() in mode Z50_SBM_WAVE) */
+typedef struct {
+    u_int32 value;                     /**< Output value */
+    u_int32 mask;                      /**< Outputs affected by value */
+    u_int32 delay;                     /**< Delay before next step [us] */
+} Z50_WAVE_STEP;
+
+/** Parameter block for Z50_BLK_WAVE_WAIT */
+typedef struct {
+    int32   timeout;                   /**< IN:  Timeout [ms] (-1=forever,
+                                            0=don't wait) */
+    u_int32 state;                     /**< OUT: Z50_WAVE_IDLE/RUNNING */
+} Z50_WAVE_WAIT_PB;
+
+/** Parameter block for Z50_BLK_PWM */
+typedef struct {
+    u_int32 mask;                      /**< IN:  Outputs to configure (get:
+                                            lowest bit selects output) */
+    u_int32 period;                    /**< IN/OUT: PWM period [us]
+                                            (0=PWM off) */
+    u_int32 duty;                      /**< IN/OUT: High time per
+                                            period [us] */
+} Z50_PWM_PB;
+
+/** Parameter block for Z50_BLK_QUARANTINE */
+typedef struct {
+    u_int32 reset;                     /**< IN:  Reset counters if 1 */
+    u_int32 numCh;                     /**< OUT: Number of valid channels */
+    u_int32 mask[Z50_MAX_CH];          /**< OUT: Quarantined inputs */
+    u_int32 count[Z50_MAX_CH][Z50_NUM_INPUTS]; /**< OUT: Number of times
+                                            each input was quarantined */
+} Z50_QUAR_PB;
+
+/** log2 histogram: bucket[0] counts values 0..1, bucket[n] values
+    2^n..2^(n+1)-1 (timestamp ticks) */
+typedef struct {
+    u_int32 count;                     /**< Number of values */
+    u_int32 max;                       /**< Largest value */
+    u_int32 bucket[Z50_HIST_BUCKETS];  /**< Values per bucket */
+} Z50_HIST;
+
+/** Parameter block for Z50_BLK_HIST */
+typedef struct {
+    u_int32  reset;                    /**< IN:  Reset histograms if 1 */
+    u_int32  tickRate;                 /**< OUT: Timestamp rate [1/s] */
+    Z50_HIST isrTime;                  /**< OUT: Duration of Z50_Irq */
+    Z50_HIST ntfDelay;                 /**< OUT: Interrupt to signal */
+    Z50_HIST irqGap;                   /**< OUT: Time between interrupts */
+} Z50_HIST_PB;
+
+/** Driver statistics */
+typedef struct {
+    u_int32 read;                      /**< Calls of M_read() */
+    u_int32 write;                     /**< Calls of M_write() */
+    u_int32 setStat;                   /**< Calls of M_setstat() */
+    u_int32 getStat;                   /**< Calls of M_getstat() */
+    u_int32 blockRead;                 /**< Calls of M_getblock() */
+    u_int32 blockWrite;                /**< Calls of M_setblock() */
+    u_int32 irqOwn;                    /**< Interrupts of this device */
+    u_int32 irqNotOwn;                 /**< Interrupts of other devices */
+    u_int32 sigSent;                   /**< Signals sent */
+    u_int32 sigFailed;                 /**< Signals failed to send */
+    u_int32 setStatCode[Z50_STAT_CODES]; /**< M_setstat() per code
+                                            M_DEV_OF+n */
+    u_int32 setStatBlkCode[Z50_STAT_BLK_CODES]; /**< M_setstat() per code
+                                            M_DEV_BLK_OF+n */
+    u_int32 setStatOther;              /**< M_setstat() with other codes */
+} Z50_STATS;
+
+/** Parameter block for Z50_BLK_STATS */
+typedef struct {
+    u_int32   reset;                   /**< IN:  Reset counters if 1 */
+    Z50_STATS stats;                   /**< OUT: Counters */
+} Z50_STATS_PB;
+
+/** Input sample (M_getblock() in mode Z50_GBM_SAMPLE) */
+typedef struct {
+    u_int32 seq;                       /**< Sample number */
+    u_int32 input;                     /**< State of inputs */
+    u_int32 raise;                     /**< Raising edges since previous
+                                            sample */
+    u_int32 fall;                      /**< Falling edges since previous
+                                            sample */
+} Z50_SAMPLE;
+
+/** Header for M_getblock() in mode Z50_GBM_SAMPLE, followed by
+    Z50_SAMPLE records */
+typedef struct {
+    u_int32 count;                     /**< Number of returned samples */
+    u_int32 pending;                   /**< Samples still queued in driver */
+    u_int32 lost;                      /**< Samples lost since last request */
+    u_int32 period;                    /**< Sample period [ms] */
+    u_int32 format;                    /**< Record format (Z50_SMP_xxx) */
+    u_int32 nextSeq;                   /**< Sequence number of next sample
+                                            (ends run of newest record
+                                            in Z50_SMP_RLE format) */
+} Z50_SAMPLE_HDR;
+
 /*-----------------------------------------+
 |  DEFINES                                 |
 +-----------------------------------------*/
@@ -70,9 +269,119 @@ typedef struct {
                                               edge on inputs */
 #define Z50_SET_SIGNAL     M_DEV_OF+0x06   /**<   S: Set signal sent on IRQ  */
 #define Z50_CLR_SIGNAL     M_DEV_OF+0x07   /**<   S: Uninstall signal        */
+#define Z50_SHADOW_CHECK   M_DEV_OF+0x08   /**< G  : Compare shadow registers
+                                              with hardware (returns
+                                              Z50_SHADOW_xxx flags) */
+#define Z50_FREQ_INPUTS    M_DEV_OF+0x09   /**< G,S: Inputs with frequency
+                                              measurement enabled */
+#define Z50_FREQ_GATE      M_DEV_OF+0x0a   /**< G,S: Gate time for frequency
+                                              measurement [ms] */
+#define Z50_SETBLOCK_MODE  M_DEV_OF+0x0b   /**< G,S: Function of M_setblock()
+                                              (Z50_SBM_xxx) */
+#define Z50_WAVE_LOOPS     M_DEV_OF+0x0c   /**< G,S: Waveform repetitions
+                                              (0=endless) */
+#define Z50_WAVE_STOP      M_DEV_OF+0x0d   /**<   S: Stop waveform playback */
+#define Z50_WAVE_STATE     M_DEV_OF+0x0e   /**< G  : Waveform playback state
+                                              (Z50_WAVE_IDLE/RUNNING) */
+#define Z50_WAVE_SIGNAL    M_DEV_OF+0x0f   /**<   S: Set signal sent at end of
+                                              waveform (0=remove) */
+#define Z50_PWM_OUTPUTS    M_DEV_OF+0x10   /**< G  : Outputs driven by PWM */
+#define Z50_GETBLOCK_MODE  M_DEV_OF+0x11   /**< G,S: Function of M_getblock()
+                                              (Z50_GBM_xxx) */
+#define Z50_SAMPLE_PERIOD  M_DEV_OF+0x12   /**< G,S: Input sample period
+                                              [ms] */
+#define Z50_SAMPLING       M_DEV_OF+0x13   /**< G,S: Input sampling of
+                                              current channel (0=off,
+                                              1=on) */
+#define Z50_SAMPLE_FORMAT  M_DEV_OF+0x14   /**< G,S: Sample record format
+                                              (Z50_SMP_xxx) */
+#define Z50_NOTIFY_HOLDOFF M_DEV_OF+0x15   /**< G,S: Minimum interval between
+                                              signals [ms] (0=off) */
+#define Z50_NOTIFY_THRESHOLD M_DEV_OF+0x16 /**< G,S: Pending edges that
+                                              send signal before holdoff
+                                              expired (0=off) */
+#define Z50_QUAR_THRESHOLD M_DEV_OF+0x17   /**< G,S: Edges per input within
+                                              window that quarantine the
+                                              input (0=off) */
+#define Z50_QUAR_WINDOW    M_DEV_OF+0x18   /**< G,S: Rate window for
+                                              quarantine [ms] */
+#define Z50_QUAR_BACKOFF   M_DEV_OF+0x19   /**< G,S: Time until quarantined
+                                              input is re-armed [ms] */
+#define Z50_QUAR_INPUTS    M_DEV_OF+0x1a   /**< G  : Quarantined inputs of
+                                              current channel */
+#define Z50_HISTOGRAM      M_DEV_OF+0x1b   /**< G,S: Interrupt timing
+                                              histograms (0=off, 1=on) */
+#define Z50_TIMER_TICK     M_DEV_OF+0x1c   /**< G  : Driver timer period
+                                              granted by the OS [ms] */
 
 #define Z50_BLK_DEBOUNCE   M_DEV_BLK_OF+0x00 /**< G,S: Get/set debouncing
                                                 time */
+#define Z50_BLK_EVENTS     M_DEV_BLK_OF+0x01 /**< G  : Get queued edge
+                                                events */
+#define Z50_BLK_WAIT_EDGE  M_DEV_BLK_OF+0x02 /**< G  : Wait for edge on
+                                                inputs */
+#define Z50_BLK_EDGE_COUNT M_DEV_BLK_OF+0x03 /**< G  : Get (and reset) edge
+                                                counters of all inputs */
+#define Z50_BLK_FREQ       M_DEV_BLK_OF+0x04 /**< G  : Get frequency/period
+                                                of all inputs */
+#define Z50_BLK_WAVE_WAIT  M_DEV_BLK_OF+0x05 /**< G  : Wait for end of
+                                                waveform */
+#define Z50_BLK_PWM        M_DEV_BLK_OF+0x06 /**< G,S: Get/set PWM period
+                                                and duty cycle of outputs */
+#define Z50_BLK_QUARANTINE M_DEV_BLK_OF+0x07 /**< G  : Get quarantined inputs
+                                                and counters */
+#define Z50_BLK_HIST       M_DEV_BLK_OF+0x08 /**< G  : Get (and reset)
+                                                interrupt timing
+                                                histograms */
+#define Z50_BLK_STATS      M_DEV_BLK_OF+0x09 /**< G  : Get (and reset)
+                                                driver statistics */
+#define Z50_BLK_EDGE_ALL   M_DEV_BLK_OF+0x0a /**< G  : Get and clear edges
+                                                of all channels */
+#define Z50_BLK_STATUS     M_DEV_BLK_OF+0x0b /**< G  : Get inputs, edges
+                                                and irq counter at once */
+#define Z50_BLK_LAYOUT     M_DEV_BLK_OF+0x0c /**< G  : Get register layout
+                                                for user mapping */
+/**@}*/
+
+/** \name Z50_SHADOW_CHECK flags
+ *  Set if the shadow copy differs from the hardware register
+ */
+/**@{*/
+#define Z50_SHADOW_IRQ_RAISE  0x01     /**< irq mask raising edge */
+#define Z50_SHADOW_IRQ_FALL   0x02     /**< irq mask falling edge */
+#define Z50_SHADOW_OUTPUT     0x04     /**< output register */
+#define Z50_SHADOW_DEBOUNCE   0x08     /**< debounce register */
+/**@}*/
+
+/** \name Z50_SETBLOCK_MODE values */
+/**@{*/
+#define Z50_SBM_OUTPUT        0        /**< write outputs of all channels */
+#define Z50_SBM_WAVE          1        /**< play Z50_WAVE_STEP sequence */
+/**@}*/
+
+/** \name Z50_GETBLOCK_MODE values */
+/**@{*/
+#define Z50_GBM_INPUT         0        /**< read inputs of all channels */
+#define Z50_GBM_SAMPLE        1        /**< read Z50_SAMPLE records */
+/**@}*/
+
+/** \name Z50_SAMPLE_FORMAT values */
+/**@{*/
+#define Z50_SMP_RAW           0        /**< one record per sample */
+#define Z50_SMP_RLE           1        /**< record only on change, run
+                                            length = difference of seq */
+/**@}*/
+
+/** \name Z50_WAVE_STATE values */
+/**@{*/
+#define Z50_WAVE_IDLE         0        /**< no waveform playing */
+#define Z50_WAVE_RUNNING      1        /**< waveform playing */
+/**@}*/
+
+/** \name Z50_LAYOUT_PB hardware types */
+/**@{*/
+#define Z50_HW_BIOC           0        /**< BIOC, one register set */
+#define Z50_HW_D302I          1        /**< D302i, one set per channel */
 /**@}*/
 
 
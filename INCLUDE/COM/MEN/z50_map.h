@@ -0,0 +1,102 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z50_map.h
+ *
+ *      \author  ulrich.bogensperger@men.de
+ *
+ *       \brief  Read accessors for a user mapping of the Z50 registers
+ *
+ *  For polling loops where even one M_read() per sample is too slow,
+ *  an application can map the register window of the unit (e.g. via UIO
+ *  or /dev/mem, at the address used by the device's BBIS) and read the
+ *  input and output registers with plain loads.
+ *
+ *  Only read accessors are provided: the edge registers are cleared on
+ *  write and the output register has a shadow copy in the driver, so
+ *  everything else must still go through the driver. Map the window
+ *  read-only where possible.
+ *
+ *  Use either the fixed layout macros of the hardware in use or get the
+ *  layout at runtime with Block GetStat Z50_BLK_LAYOUT. The driver only
+ *  describes the layout, it neither provides the mapping nor knows the
+ *  physical address of the unit.
+ *
+ *    \switches  _BIG_ENDIAN_
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2004-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _Z50_MAP_H
+#define _Z50_MAP_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+typedef volatile u_int32 *Z50_MAP;     /**< user mapping of the registers */
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+/* registers are little endian, like MREAD_D32 swap on big endian CPUs
+   (function, so the register is read only once) */
+#ifdef _BIG_ENDIAN_
+static __inline__ u_int32 Z50_MapLe32( u_int32 v )
+{
+    return (v << 24) | ((v & 0xff00) << 8) | ((v >> 8) & 0xff00) | (v >> 24);
+}
+# define Z50_MAP_LE32(v)    Z50_MapLe32( v )
+#else
+# define Z50_MAP_LE32(v)    (v)
+#endif
+
+/** \name BIOC layout (one register set) */
+/**@{*/
+#define Z50_MAP_BIOC_SIZE       0x100   /**< register window [bytes] */
+#define Z50_MAP_BIOC_IO_SIZE    0x08    /**< input/output only [bytes] */
+#define Z50_MAP_BIOC_INPUT(m)   Z50_MAP_LE32( (u_int32)(m)[0x00/4] )
+#define Z50_MAP_BIOC_OUTPUT(m)  Z50_MAP_LE32( (u_int32)(m)[0x04/4] )
+/**@}*/
+
+/** \name D302i layout (one register set per channel, ch<4) */
+/**@{*/
+#define Z50_MAP_D302I_SIZE      0x100   /**< register window [bytes] */
+#define Z50_MAP_D302I_IO_SIZE   0x20    /**< inputs/outputs only [bytes] */
+#define Z50_MAP_D302I_INPUT(m,ch) \
+    Z50_MAP_LE32( (u_int32)(m)[0x00/4 + (ch)] )
+#define Z50_MAP_D302I_OUTPUT(m,ch) \
+    Z50_MAP_LE32( (u_int32)(m)[0x10/4 + (ch)] )
+/**@}*/
+
+/** \name Layout from Z50_BLK_LAYOUT (lay: Z50_LAYOUT_PB*) */
+/**@{*/
+#define Z50_MAP_INPUT(m,lay,ch) \
+    Z50_MAP_LE32( (u_int32)(m)[((lay)->input + (ch)*(lay)->chStride)/4] )
+#define Z50_MAP_OUTPUT(m,lay,ch) \
+    Z50_MAP_LE32( (u_int32)(m)[((lay)->output + (ch)*(lay)->chStride)/4] )
+/**@}*/
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z50_MAP_H */